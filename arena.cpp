@@ -0,0 +1,78 @@
+/*
+ * This file is part of PrefixTree
+ *
+ * The MIT License (MIT)
+ * 
+ * Copyright (c) 2016 Jon Chesterfield
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "arena.hpp"
+#include "catch.hpp"
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+TEST_CASE("arena aligns and copies")
+{
+  prefix::arena a(256);
+  CHECK(0 == a.reserved());
+  const char* s = a.copy("abc", 3);
+  CHECK(0 == std::memcmp(s, "abc", 3));
+  std::uint64_t* n = a.allocate<std::uint64_t>(3);
+  CHECK(0 == reinterpret_cast<std::uintptr_t>(n) % alignof(std::uint64_t));
+  n[0] = n[1] = n[2] = 7;
+  CHECK(a.used() == 3 + 3 * sizeof(std::uint64_t));
+  CHECK(256 == a.reserved());
+  CHECK(0 == std::memcmp(s, "abc", 3));
+}
+
+TEST_CASE("arena blocks")
+{
+  prefix::arena a(256);
+  // Fills one block, then starts another
+  for (int i = 0; i < 5; i++)
+    {
+      a.allocate<char>(60);
+    }
+  CHECK(512 == a.reserved());
+  // Too large to share a block, so the current one is kept
+  char* big = a.allocate<char>(1000);
+  std::memset(big, 0, 1000);
+  CHECK(1513 == a.reserved());
+  a.allocate<char>(60);
+  CHECK(1513 == a.reserved());
+  CHECK(1360 == a.used());
+}
+
+TEST_CASE("aligned allocator")
+{
+  for (std::size_t n : {1, 63, 64, 1000})
+    {
+      std::vector<unsigned char, prefix::aligned_allocator<unsigned char, 64>>
+          v(n, 7);
+      CHECK(0 == reinterpret_cast<std::uintptr_t>(v.data()) % 64);
+      const std::vector<unsigned char,
+                        prefix::aligned_allocator<unsigned char, 64>>
+          copy(v);
+      CHECK(0 == reinterpret_cast<std::uintptr_t>(copy.data()) % 64);
+      CHECK(copy == v);
+    }
+}
@@ -0,0 +1,170 @@
+/*
+ * This file is part of PrefixTree
+ *
+ * The MIT License (MIT)
+ * 
+ * Copyright (c) 2016 Jon Chesterfield
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifndef ARENA_HPP
+#define ARENA_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <vector>
+
+namespace prefix
+{
+// Bump allocation from large blocks, for structures built once and then
+// dropped as a whole. Nothing is freed until the arena is, so objects
+// must not need destroying
+class arena
+{
+ public:
+  explicit arena(std::size_t block = std::size_t(1) << 20)
+      : block(block), next(nullptr), end(nullptr), used_(0), reserved_(0)
+  {
+  }
+
+  arena(const arena&) = delete;
+  arena& operator=(const arena&) = delete;
+
+  // Uninitialised, aligned to align, a power of two
+  void* allocate(std::size_t bytes, std::size_t align)
+  {
+    std::size_t pad = (align - reinterpret_cast<std::uintptr_t>(next)) &
+                      (align - 1);
+    if (next == nullptr || bytes + pad > std::size_t(end - next))
+      {
+        // Large requests get a block of their own, keeping the current one
+        if (bytes + align > block / 4)
+          {
+            used_ += bytes;
+            return fresh(bytes + align, align);
+          }
+        next = static_cast<char*>(fresh(block, 1));
+        end = next + block;
+        pad = (align - reinterpret_cast<std::uintptr_t>(next)) & (align - 1);
+      }
+    char* p = next + pad;
+    next = p + bytes;
+    used_ += bytes;
+    return p;
+  }
+
+  // n uninitialised objects
+  template <typename T>
+  T* allocate(std::size_t n)
+  {
+    static_assert(std::is_trivially_destructible<T>::value,
+                  "Arena objects are never destroyed");
+    return static_cast<T*>(allocate(n * sizeof(T), alignof(T)));
+  }
+
+  const char* copy(const char* data, std::size_t length)
+  {
+    char* p = allocate<char>(length);
+    if (length)
+      {
+        std::memcpy(p, data, length);
+      }
+    return p;
+  }
+
+  // Bytes handed out
+  std::size_t used() const { return used_; }
+
+  // Bytes taken from the heap
+  std::size_t reserved() const { return reserved_; }
+
+ private:
+  // A new block of bytes, returning its first address aligned to align
+  void* fresh(std::size_t bytes, std::size_t align)
+  {
+    blocks.emplace_back(new char[bytes]);
+    reserved_ += bytes;
+    char* p = blocks.back().get();
+    return p + ((align - reinterpret_cast<std::uintptr_t>(p)) & (align - 1));
+  }
+
+  std::size_t block;
+  char* next;
+  char* end;
+  std::size_t used_;
+  std::size_t reserved_;
+  std::vector<std::unique_ptr<char[]>> blocks;
+};
+
+// Heap memory aligned to A bytes, a power of two, for containers laid out
+// around cache lines
+template <typename T, std::size_t A>
+struct aligned_allocator
+{
+  typedef T value_type;
+
+  template <typename U>
+  struct rebind
+  {
+    typedef aligned_allocator<U, A> other;
+  };
+
+  aligned_allocator() {}
+
+  template <typename U>
+  aligned_allocator(const aligned_allocator<U, A>&)
+  {
+  }
+
+  // The address operator new returned is kept just before the block
+  T* allocate(std::size_t n)
+  {
+    static_assert(A >= 2 * sizeof(void*), "Room for the address");
+    char* raw = static_cast<char*>(::operator new(n * sizeof(T) + A));
+    char* p = raw + A - (reinterpret_cast<std::uintptr_t>(raw) & (A - 1));
+    std::memcpy(p - sizeof(raw), &raw, sizeof(raw));
+    return reinterpret_cast<T*>(p);
+  }
+
+  void deallocate(T* p, std::size_t)
+  {
+    char* raw;
+    std::memcpy(&raw, reinterpret_cast<char*>(p) - sizeof(raw), sizeof(raw));
+    ::operator delete(raw);
+  }
+
+  template <typename U>
+  bool operator==(const aligned_allocator<U, A>&) const
+  {
+    return true;
+  }
+
+  template <typename U>
+  bool operator!=(const aligned_allocator<U, A>&) const
+  {
+    return false;
+  }
+};
+}
+
+#endif  // ARENA_HPP
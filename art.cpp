@@ -0,0 +1,187 @@
+/*
+ * This file is part of PrefixTree
+ *
+ * The MIT License (MIT)
+ * 
+ * Copyright (c) 2016 Jon Chesterfield
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "art.hpp"
+#include "runtime.hpp"
+#include "catch.hpp"
+
+#include <string>
+#include <vector>
+
+TEST_CASE("art table matches runtime table")
+{
+  // Rows prefixing one another, long shared runs and a wide fan out
+  std::vector<std::string> rows = {"",
+                                   "content-encoding",
+                                   "content-language",
+                                   "content-length",
+                                   "content-type",
+                                   "context",
+                                   "cookie",
+                                   "\xff",
+                                   "/api/v1/users",
+                                   "/api/v1/users/",
+                                   "/api/v1/users/me",
+                                   "/api/v2/users"};
+  for (char c = 'a'; c <= 'z'; c++)
+    {
+      rows.push_back(std::string("x") + c);
+      rows.push_back(std::string("y") + c + c);
+    }
+  for (int c = 1; c < 256; c += 3)
+    {
+      rows.push_back(std::string("z") + char(c) + "end");
+    }
+  const prefix::runtime_table r(rows);
+  const prefix::art_table t(rows);
+  REQUIRE(r.size() == t.size());
+  for (std::size_t i = 0; i < t.size(); i++)
+    {
+      CHECK(r.get(i) == t.get(i));
+    }
+
+  std::vector<std::string> keys = {"content-type: text", "content-lengt",
+                                   "contex",             "cookies",
+                                   "",                   "\xff\xff",
+                                   "\xfe",               "/api/v1/user",
+                                   "/api/v1/users/you",  "/api/v3",
+                                   "xz",                 "yzz",
+                                   "yz",                 "z\x04",
+                                   "z\x04" "e",          "z\x05" "end"};
+  keys.insert(keys.end(), rows.begin(), rows.end());
+  for (const std::string& k : keys)
+    {
+      CHECK(r.lookup_index(k.c_str()) == t.lookup_index(k.c_str()));
+      for (std::size_t n = 0; n <= k.size(); n++)
+        {
+          CHECK(r.lookup_index(k.data(), n) == t.lookup_index(k.data(), n));
+        }
+    }
+
+  CHECK(t.count(prefix::art_table::node4) > 0);
+  CHECK(t.count(prefix::art_table::node16) == 1);  // The root
+  CHECK(t.count(prefix::art_table::node48) == 2);
+  CHECK(t.count(prefix::art_table::node256) == 1);
+  CHECK(t.count(prefix::art_table::leaf) > 0);
+}
+
+TEST_CASE("art table node kinds")
+{
+  std::vector<std::string> rows;
+  for (char c = 'a'; c < 'a' + 10; c++)
+    {
+      rows.push_back(std::string("key") + c);
+    }
+  const prefix::art_table t(rows);
+  // One node16 under the shared "key", then a leaf per row
+  CHECK(1 == t.count(prefix::art_table::node16));
+  CHECK(10 == t.count(prefix::art_table::leaf));
+  CHECK(0 == t.count(prefix::art_table::node4));
+  for (std::size_t i = 0; i < rows.size(); i++)
+    {
+      CHECK(i == t.lookup_index(rows[i].c_str()));
+    }
+  CHECK(t.fail() == t.lookup_index("keyk"));
+  CHECK(t.fail() == t.lookup_index("ke"));
+}
+
+TEST_CASE("art table built in parallel matches serial")
+{
+  std::vector<std::string> rows;
+  for (std::size_t i = 0; i < 20000; i++)
+    {
+      rows.push_back(std::string(1, "abcdefghij"[i % 10]) + ".host" +
+                     std::to_string(i % 97) + ".m" + std::to_string(i));
+    }
+  rows.push_back("a");
+  rows.push_back("");
+  const prefix::art_table serial(rows);
+  for (unsigned threads : {2u, 3u, 16u})
+    {
+      const prefix::art_table parallel(rows.begin(), rows.end(), threads);
+      REQUIRE(serial.size() == parallel.size());
+      CHECK(serial.bytes() == parallel.bytes());
+      for (int k = 0; k < prefix::art_table::kinds; k++)
+        {
+          const prefix::art_table::kind n = prefix::art_table::kind(k);
+          CHECK(serial.count(n) == parallel.count(n));
+        }
+      std::size_t same = 0;
+      for (std::size_t i = 0; i < rows.size(); i++)
+        {
+          const std::string miss = rows[i] + "x";
+          same += (serial.get(i) == parallel.get(i)) &&
+                  (i == parallel.lookup_index(parallel.get(i).c_str())) &&
+                  (serial.lookup_index(miss.c_str()) ==
+                   parallel.lookup_index(miss.c_str())) &&
+                  (serial.lookup_index(miss.data(), 3) ==
+                   parallel.lookup_index(miss.data(), 3));
+        }
+      CHECK(same == rows.size());
+    }
+}
+
+TEST_CASE("art table blocked layout")
+{
+  std::vector<std::string> rows;
+  for (std::size_t i = 0; i < 5000; i++)
+    {
+      rows.push_back(std::string(1, "abcdefg"[i % 7]) + ".host" +
+                     std::to_string(i / 7 % 100) + ".m" +
+                     std::to_string(i % 13) + "_" + std::to_string(i));
+    }
+  const prefix::art_table wide(rows);
+  const prefix::art_table blocked(rows, 1, prefix::art_table::blocked);
+  REQUIRE(wide.size() == blocked.size());
+  CHECK(wide.bytes() <= blocked.bytes());
+  std::size_t same = 0, wide_lines = 0, blocked_lines = 0;
+  for (std::size_t i = 0; i < rows.size(); i++)
+    {
+      const std::string& k = rows[i];
+      same +=
+          (wide.lookup_index(k.c_str()) == blocked.lookup_index(k.c_str())) &&
+          (wide.lookup_index(k.data(), 4) == blocked.lookup_index(k.data(), 4));
+      wide_lines += wide.lines(k.c_str(), k.size() + 1);
+      blocked_lines += blocked.lines(k.c_str(), k.size() + 1);
+    }
+  CHECK(same == rows.size());
+  CHECK(blocked_lines < wide_lines);
+  CHECK(blocked.fail() == blocked.lookup_index("h.host"));
+
+  // The root alone, at the start of a line
+  const std::vector<std::string> one(1, "x");
+  const prefix::art_table leaf(one, 1, prefix::art_table::blocked);
+  CHECK(1 == leaf.lines("x", 2));
+  CHECK(0 == leaf.lookup_index("xy"));
+}
+
+TEST_CASE("art table without rows")
+{
+  const std::vector<std::string> none;
+  const prefix::art_table t(none);
+  CHECK(0 == t.size());
+  CHECK(1 == t.count(prefix::art_table::leaf));
+  CHECK(t.fail() == t.lookup_index("anything"));
+}
@@ -0,0 +1,626 @@
+/*
+ * This file is part of PrefixTree
+ *
+ * The MIT License (MIT)
+ * 
+ * Copyright (c) 2016 Jon Chesterfield
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifndef ART_HPP
+#define ART_HPP
+
+#include "arena.hpp"
+#include "batch.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <memory>
+#include <numeric>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+namespace prefix
+{
+// A table built at runtime as an adaptive radix tree. Each node takes the
+// smallest of four layouts that fits its number of children, so sparse
+// nodes stay small and dense ones index their child directly. Runs of
+// nodes with one child and no row are compressed into a prefix stored in
+// the node below them. Lookups match as crtp::lookup_index_critbit.
+//
+// Keys and nodes are first built in arenas, then nodes are laid out in
+// one byte array, children referred to by offset, and the arenas dropped.
+// Given threads, rows are sorted in parallel and the subtree under each
+// child of the root drafted at once
+class art_table
+{
+ public:
+  enum kind
+  {
+    leaf,     // No children
+    node4,    // Up to 4 characters, searched in turn
+    node16,   // Up to 16, compared at once
+    node48,   // Up to 48, a byte per character indexes the children
+    node256,  // A child per character
+    kinds
+  };
+
+  // Order of nodes in the array
+  enum layout
+  {
+    breadth_first,  // Siblings adjacent, a level at a time
+    blocked,        // Each cache line starts a node, then takes as many of
+                    // the descendants holding the most rows as fit
+  };
+
+  static const std::size_t line = 64;
+
+  template <typename It>
+  art_table(It begin, It end, unsigned threads = 1,
+            layout order = breadth_first)
+  {
+    std::vector<view> rows;
+    {
+      // Keys are sorted in an arena of their own, then copied into text
+      // and that arena dropped before any node is drafted
+      arena keys;
+      reserve(rows, begin, end,
+              typename std::iterator_traits<It>::iterator_category());
+      for (; begin != end; ++begin)
+        {
+          const std::string& row = *begin;
+          rows.push_back(view{keys.copy(row.data(), row.size()), row.size()});
+        }
+      parallel_sort(rows.begin(), rows.end(), threads);
+      rows.erase(std::unique(rows.begin(), rows.end()), rows.end());
+      if (rows.size() >= none)
+        {
+          throw std::length_error("Too many rows for art_table");
+        }
+      std::size_t length = 0;
+      for (const view& row : rows)
+        {
+          length += row.size;
+        }
+      text.reserve(length);
+      ends.reserve(rows.size());
+      for (const view& row : rows)
+        {
+          text.append(row.data, row.size);
+          ends.push_back(text.size());
+        }
+    }
+    for (std::size_t i = 0; i < rows.size(); i++)
+      {
+        rows[i].data = text.data() + (ends[i] - rows[i].size);
+      }
+
+    arena drafts;
+    std::vector<std::unique_ptr<arena>> parts;
+    tally t = tally();
+    draft* root =
+        (threads > 1)
+            ? sketch(drafts, parts, rows.data(), rows.size(), threads, t)
+            : sketch(drafts, rows.data(), 0, rows.size(), 0, t);
+    std::vector<view>().swap(rows);
+    if (t.total >= none)
+      {
+        throw std::length_error("Too many nodes for art_table");
+      }
+    std::copy(t.counts, t.counts + kinds, counts);
+    if (order == blocked)
+      {
+        lay_out_blocked(root);
+      }
+    else
+      {
+        lay_out(root, t.total);
+      }
+  }
+
+  explicit art_table(const std::vector<std::string>& keys,
+                     unsigned threads = 1, layout order = breadth_first)
+      : art_table(keys.begin(), keys.end(), threads, order)
+  {
+  }
+
+  std::size_t size() const { return ends.size(); }
+
+  // Returned if lookup_index fails
+  std::size_t fail() const { return size(); }
+
+  // Row i, in sorted order
+  std::string get(std::size_t i) const
+  {
+    const std::size_t begin = i ? ends.at(i - 1) : 0;
+    return text.substr(begin, ends.at(i) - begin);
+  }
+
+  std::size_t lookup_index(const char* key) const
+  {
+    return lookup_index(key, std::strlen(key) + 1);
+  }
+
+  std::size_t lookup_index(const char* key, std::size_t length) const
+  {
+    return find(key, length, [](const unsigned char*, std::size_t) {});
+  }
+
+  // Cache lines of the nodes read looking up key
+  std::size_t lines(const char* key, std::size_t length) const
+  {
+    std::vector<std::uintptr_t> seen;
+    find(key, length, [&](const unsigned char* p, std::size_t n) {
+      const std::uintptr_t first = reinterpret_cast<std::uintptr_t>(p);
+      for (std::uintptr_t l = first / line; n && l <= (first + n - 1) / line;
+           l++)
+        {
+          if (std::find(seen.begin(), seen.end(), l) == seen.end())
+            {
+              seen.push_back(l);
+            }
+        }
+    });
+    return seen.size();
+  }
+
+  // Bytes taken by the nodes
+  std::size_t bytes() const { return nodes.size(); }
+
+  // Nodes of layout k
+  std::size_t count(kind k) const { return counts[k]; }
+
+ private:
+  static const std::uint32_t none = 0xffffffffu;
+
+  struct header
+  {
+    unsigned char type;
+    unsigned char pad;
+    std::uint16_t children;
+    std::uint32_t row;     // Ending here, or none
+    std::uint32_t prefix;  // Characters that follow, before any child
+  };
+
+  // Looks up key, calling touch(p, n) on each range of nodes read
+  template <typename F>
+  std::size_t find(const char* key, std::size_t length, const F& touch) const
+  {
+    const unsigned char* k = reinterpret_cast<const unsigned char*>(key);
+    std::size_t found = fail();
+    std::size_t at = 0;
+    for (std::size_t d = 0;;)
+      {
+        header h;
+        std::memcpy(&h, &nodes[at], sizeof(h));
+        const unsigned char* p = &nodes[at] + sizeof(h);
+        touch(&nodes[at], sizeof(h) + h.prefix);
+        if (h.prefix > length - d || std::memcmp(p, k + d, h.prefix) != 0)
+          {
+            return found;
+          }
+        d += h.prefix;
+        p += h.prefix;
+        if (h.row != none)
+          {
+            found = h.row;
+          }
+        if (d == length || h.type == leaf)
+          {
+            return found;
+          }
+        const unsigned char* s = slot(h, p, k[d++], touch);
+        if (s == nullptr)
+          {
+            return found;
+          }
+        touch(s, sizeof(std::uint32_t));
+        at = load(s);
+        if (at == 0)
+          {
+            return found;
+          }
+      }
+  }
+
+  static std::uint32_t load(const unsigned char* p)
+  {
+    std::uint32_t v;
+    std::memcpy(&v, p, sizeof(v));
+    return v;
+  }
+
+  // Where the offset of the child for c is held, or null if there is
+  // none. Calls touch on the characters read to find it
+  template <typename F>
+  static const unsigned char* slot(const header& h, const unsigned char* p,
+                                   unsigned char c, const F& touch)
+  {
+    switch (h.type)
+      {
+        case node4:
+          touch(p, h.children);
+          for (unsigned i = 0; i < h.children; i++)
+            {
+              if (p[i] == c)
+                {
+                  return p + 4 + 4 * i;
+                }
+            }
+          return nullptr;
+        case node16:
+          {
+            touch(p, 16);
+#ifdef __SSE2__
+            const __m128i keys =
+                _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+            const unsigned hits =
+                static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpeq_epi8(
+                    keys, _mm_set1_epi8(static_cast<char>(c))))) &
+                ((1u << h.children) - 1);
+            return hits ? p + 16 + 4 * __builtin_ctz(hits) : nullptr;
+#else
+            for (unsigned i = 0; i < h.children; i++)
+              {
+                if (p[i] == c)
+                  {
+                    return p + 16 + 4 * i;
+                  }
+              }
+            return nullptr;
+#endif
+          }
+        case node48:
+          touch(p + c, 1);
+          return p[c] ? p + 256 + 4 * (p[c] - 1) : nullptr;
+        case node256:
+          return p + 4 * c;
+        default:
+          return nullptr;
+      }
+  }
+
+  static kind fits(std::size_t children)
+  {
+    return (children == 0)
+               ? leaf
+               : (children <= 4) ? node4
+                                 : (children <= 16)
+                                       ? node16
+                                       : (children <= 48) ? node48 : node256;
+  }
+
+  // Bytes after the prefix for layout k
+  static std::size_t body(kind k)
+  {
+    return (k == node4) ? 4 + 4 * 4
+                        : (k == node16) ? 16 + 4 * 16
+                                        : (k == node48)
+                                              ? 256 + 4 * 48
+                                              : (k == node256) ? 4 * 256 : 0;
+  }
+
+  // A row while building, in the arena
+  struct view
+  {
+    const char* data;
+    std::size_t size;
+
+    bool operator<(const view& o) const
+    {
+      const int c = std::memcmp(data, o.data, std::min(size, o.size));
+      return c < 0 || (c == 0 && size < o.size);
+    }
+
+    bool operator==(const view& o) const
+    {
+      return size == o.size && std::memcmp(data, o.data, size) == 0;
+    }
+  };
+
+  template <typename It>
+  static void reserve(std::vector<view>& rows, It begin, It end,
+                      std::forward_iterator_tag)
+  {
+    rows.reserve(std::distance(begin, end));
+  }
+
+  template <typename It>
+  static void reserve(std::vector<view>&, It, It, std::input_iterator_tag)
+  {
+  }
+
+  // A node while building, before it has a place in nodes. Pointers to
+  // its children follow it in the arena, then their characters
+  struct draft
+  {
+    header h;
+    std::uint32_t at;      // Offset once laid out
+    std::uint32_t weight;  // Rows in the subtree
+    const char* prefix;
+
+    draft** children() { return reinterpret_cast<draft**>(this + 1); }
+
+    unsigned char* chars()
+    {
+      return reinterpret_cast<unsigned char*>(children() + h.children);
+    }
+  };
+
+  static std::size_t footprint(const draft& d)
+  {
+    return sizeof(header) + d.h.prefix + body(static_cast<kind>(d.h.type));
+  }
+
+  // Nodes of each layout and the bytes they will take
+  struct tally
+  {
+    std::size_t counts[kinds];
+    std::size_t total;
+  };
+
+  // Drafts the node for rows [L, U), which share their first D characters
+  // and whose parent consumed the last of them, without its children.
+  // Moves L past any row ending at the node, and sets P to the length of
+  // the rows it holds
+  draft* node(arena& a, const view* rows, std::size_t& L, std::size_t U,
+              std::size_t D, std::size_t& P, tally& t)
+  {
+    const std::size_t weight = U - L;
+    // Rows are sorted, so the first and last share what all of them do
+    P = D;
+    if (L < U)
+      {
+        const view& x = rows[L];
+        const view& y = rows[U - 1];
+        P = (L + 1 == U) ? x.size : D;
+        while (L + 1 < U && P < x.size && P < y.size && x.data[P] == y.data[P])
+          {
+            P++;
+          }
+      }
+    header h = {0, 0, 0, none, static_cast<std::uint32_t>(P - D)};
+    const char* prefix = (L < U) ? rows[L].data + D : nullptr;
+    if (L < U && rows[L].size == P)
+      {
+        h.row = static_cast<std::uint32_t>(L++);
+      }
+
+    // Characters at P split the rest into groups
+    std::size_t groups = 0;
+    for (std::size_t i = L; i < U; i++)
+      {
+        groups += (i == L || rows[i].data[P] != rows[i - 1].data[P]);
+      }
+    const kind k = fits(groups);
+    h.type = static_cast<unsigned char>(k);
+    h.children = static_cast<std::uint16_t>(groups);
+    draft* d = static_cast<draft*>(a.allocate(
+        sizeof(draft) + groups * (sizeof(draft*) + 1), alignof(draft)));
+    d->h = h;
+    d->weight = static_cast<std::uint32_t>(weight);
+    d->prefix = prefix;
+    for (std::size_t g = 0, start = L; g < groups; g++)
+      {
+        d->chars()[g] = static_cast<unsigned char>(rows[start].data[P]);
+        start = group_end(rows, start, U, P);
+      }
+    t.counts[k]++;
+    t.total += footprint(*d);
+    return d;
+  }
+
+  // End of the rows from start sharing the character at P
+  static std::size_t group_end(const view* rows, std::size_t start,
+                               std::size_t U, std::size_t P)
+  {
+    std::size_t end = start + 1;
+    while (end < U && rows[end].data[P] == rows[start].data[P])
+      {
+        end++;
+      }
+    return end;
+  }
+
+  // The node for rows [L, U), as above, and its children
+  draft* sketch(arena& a, const view* rows, std::size_t L, std::size_t U,
+                std::size_t D, tally& t)
+  {
+    std::size_t P;
+    draft* d = node(a, rows, L, U, D, P, t);
+    for (std::size_t g = 0, start = L; g < d->h.children; g++)
+      {
+        const std::size_t end = group_end(rows, start, U, P);
+        d->children()[g] = sketch(a, rows, start, end, P + 1, t);
+        start = end;
+      }
+    return d;
+  }
+
+  // The root for all count rows and its children, drafting the subtree
+  // under each child over up to threads threads, in arenas added to parts
+  draft* sketch(arena& a, std::vector<std::unique_ptr<arena>>& parts,
+                const view* rows, std::size_t count, unsigned threads,
+                tally& t)
+  {
+    std::size_t L = 0, P;
+    draft* root = node(a, rows, L, count, 0, P, t);
+    const std::size_t groups = root->h.children;
+    std::vector<std::size_t> starts(1, L);
+    for (std::size_t g = 0; g < groups; g++)
+      {
+        starts.push_back(group_end(rows, starts.back(), count, P));
+      }
+    std::vector<tally> tallies(groups, tally());
+    parts.resize(groups);
+    parallel_blocks(groups, threads,
+                    [&](std::size_t begin, std::size_t end) {
+                      for (std::size_t g = begin; g < end; g++)
+                        {
+                          // Blocks in proportion, so small groups stay small
+                          const std::size_t n = starts[g + 1] - starts[g];
+                          parts[g].reset(new arena(std::min<std::size_t>(
+                              std::size_t(1) << 20,
+                              std::max<std::size_t>(4096, 64 * n))));
+                          root->children()[g] =
+                              sketch(*parts[g], rows, starts[g],
+                                     starts[g + 1], P + 1, tallies[g]);
+                        }
+                    },
+                    1);
+    for (const tally& part : tallies)
+      {
+        for (std::size_t k = 0; k < kinds; k++)
+          {
+            t.counts[k] += part.counts[k];
+          }
+        t.total += part.total;
+      }
+    return root;
+  }
+
+  // Places drafts breadth first, so siblings are adjacent, and writes them
+  void lay_out(draft* root, std::size_t total)
+  {
+    nodes.assign(total, 0);
+    std::vector<draft*> queue;
+    queue.reserve(std::accumulate(counts, counts + kinds, std::size_t(0)));
+    queue.push_back(root);
+    root->at = 0;
+    std::size_t cursor = footprint(*root);
+    for (std::size_t q = 0; q < queue.size(); q++)
+      {
+        draft& d = *queue[q];
+        for (unsigned g = 0; g < d.h.children; g++)
+          {
+            draft* child = d.children()[g];
+            child->at = static_cast<std::uint32_t>(cursor);
+            cursor += footprint(*child);
+            queue.push_back(child);
+          }
+        write(d);
+      }
+  }
+
+  // Places each draft from a queue where it starts a cache line or fits in
+  // what is left of one, then fills the rest of its last line with as many
+  // of its descendants as fit, those holding the most rows first.
+  // Descendants that do not fit join the queue
+  void lay_out_blocked(draft* root)
+  {
+    const std::size_t total =
+        std::accumulate(counts, counts + kinds, std::size_t(0));
+    std::vector<draft*> placed;
+    placed.reserve(total);
+    std::vector<draft*> queue(1, root);
+    std::vector<draft*> frontier;
+    auto lighter = [](const draft* x, const draft* y) {
+      return x->weight < y->weight;
+    };
+    std::size_t cursor = 0;
+    for (std::size_t q = 0; q < queue.size(); q++)
+      {
+        if (cursor % line + footprint(*queue[q]) > line)
+          {
+            cursor = (cursor + line - 1) / line * line;
+          }
+        const std::size_t end =
+            (cursor + footprint(*queue[q]) + line - 1) / line * line;
+        frontier.assign(1, queue[q]);
+        while (!frontier.empty())
+          {
+            std::pop_heap(frontier.begin(), frontier.end(), lighter);
+            draft* d = frontier.back();
+            frontier.pop_back();
+            if (d != queue[q] && cursor + footprint(*d) > end)
+              {
+                queue.push_back(d);
+                continue;
+              }
+            if (cursor + footprint(*d) >= none)
+              {
+                throw std::length_error("Too many nodes for art_table");
+              }
+            d->at = static_cast<std::uint32_t>(cursor);
+            cursor += footprint(*d);
+            placed.push_back(d);
+            for (unsigned g = 0; g < d->h.children; g++)
+              {
+                frontier.push_back(d->children()[g]);
+                std::push_heap(frontier.begin(), frontier.end(), lighter);
+              }
+          }
+      }
+    nodes.assign(cursor, 0);
+    for (draft* d : placed)
+      {
+        write(*d);
+      }
+  }
+
+  void write(draft& d)
+  {
+    unsigned char* p = &nodes[d.at];
+    std::memcpy(p, &d.h, sizeof(d.h));
+    p += sizeof(d.h);
+    if (d.h.prefix)
+      {
+        std::memcpy(p, d.prefix, d.h.prefix);
+        p += d.h.prefix;
+      }
+    for (unsigned g = 0; g < d.h.children; g++)
+      {
+        const unsigned char c = d.chars()[g];
+        unsigned char* slot;
+        switch (d.h.type)
+          {
+            case node4:
+            case node16:
+              p[g] = c;
+              slot = p + ((d.h.type == node4) ? 4 : 16) + 4 * g;
+              break;
+            case node48:
+              p[c] = static_cast<unsigned char>(g + 1);
+              slot = p + 256 + 4 * g;
+              break;
+            default:
+              slot = p + 4 * c;
+              break;
+          }
+        std::memcpy(slot, &d.children()[g]->at, sizeof(std::uint32_t));
+      }
+  }
+
+  std::string text;               // Rows, one after another
+  std::vector<std::size_t> ends;  // Of each row in text
+  // Aligned, so offsets in line with each other share a cache line
+  std::vector<unsigned char, aligned_allocator<unsigned char, line>> nodes;
+  std::size_t counts[kinds];
+};
+}
+
+#endif  // ART_HPP
@@ -0,0 +1,123 @@
+/*
+ * This file is part of PrefixTree
+ *
+ * The MIT License (MIT)
+ * 
+ * Copyright (c) 2016 Jon Chesterfield
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "batch.hpp"
+#include "catch.hpp"
+
+#include <algorithm>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace
+{
+struct colours : prefix::crtp<colours>
+{
+  static constexpr element table[] = {
+      "blue", "cyan", "green", "grey", "magenta", "red", "white", "yellow",
+  };
+};
+}
+constexpr decltype(colours::table) colours::table;
+
+TEST_CASE("parallel blocks cover every row once")
+{
+  const std::size_t counts[] = {0, 1, 1023, 1024, 5000, 100000};
+  for (std::size_t count : counts)
+    {
+      for (unsigned threads : {1u, 2u, 3u, 8u})
+        {
+          std::vector<std::atomic<unsigned>> seen(count);
+          for (std::atomic<unsigned>& s : seen)
+            {
+              s = 0;
+            }
+          prefix::parallel_blocks(
+              count, threads,
+              [&](std::size_t begin, std::size_t end) {
+                for (std::size_t i = begin; i < end; i++)
+                  {
+                    seen[i]++;
+                  }
+              },
+              64);
+          std::size_t once = 0;
+          for (std::atomic<unsigned>& s : seen)
+            {
+              once += (s == 1);
+            }
+          CHECK(once == count);
+        }
+    }
+}
+
+TEST_CASE("parallel sort")
+{
+  const std::size_t counts[] = {0, 1, 1000, 5000, 33333};
+  for (std::size_t count : counts)
+    {
+      std::vector<unsigned> input(count);
+      for (std::size_t i = 0; i < count; i++)
+        {
+          input[i] = static_cast<unsigned>((i * 2654435761u) % 1000);
+        }
+      std::vector<unsigned> expect(input);
+      std::sort(expect.begin(), expect.end());
+      for (unsigned threads : {1u, 2u, 3u, 8u})
+        {
+          std::vector<unsigned> v(input);
+          prefix::parallel_sort(v.begin(), v.end(), threads);
+          CHECK(expect == v);
+        }
+      std::vector<unsigned> v(input);
+      prefix::parallel_sort(v.begin(), v.end(), 5, std::greater<unsigned>());
+      CHECK(std::equal(expect.rbegin(), expect.rend(), v.begin()));
+    }
+}
+
+TEST_CASE("parallel lookup batch matches serial")
+{
+  const char* words[] = {"blue",  "bluer", "cyan", "grey", "gree",
+                         "green", "red",   "",     "yellowish", "white"};
+  std::vector<const char*> keys;
+  for (std::size_t i = 0; i < 50000; i++)
+    {
+      keys.push_back(words[(i * 7) % 10]);
+    }
+  std::vector<std::size_t> serial(keys.size());
+  prefix::lookup_batch<colours>(keys.data(), keys.size(), serial.data());
+  CHECK(0 == serial[0]);                // blue
+  CHECK(colours::fail() == serial[2]);  // gree
+  CHECK(7 == serial[4]);                // yellowish
+
+
+  for (unsigned threads : {1u, 2u, 4u, 7u})
+    {
+      std::vector<std::size_t> parallel(keys.size(), 12345);
+      prefix::lookup_batch<colours>(keys.data(), keys.size(),
+                                    parallel.data(), threads);
+      CHECK(serial == parallel);
+    }
+}
@@ -0,0 +1,245 @@
+/*
+ * This file is part of PrefixTree
+ *
+ * The MIT License (MIT)
+ * 
+ * Copyright (c) 2016 Jon Chesterfield
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifndef BATCH_HPP
+#define BATCH_HPP
+
+#include "prefix.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <thread>
+#include <vector>
+
+namespace prefix
+{
+// Rows [begin, end) of the input left to one thread, packed in one word
+// so that its owner and thieves can both take from it with a single
+// compare and swap. begin never passes end. Padded to a cache line each
+struct alignas(64) batch_range
+{
+  std::atomic<std::uint64_t> bounds;
+
+  static std::uint64_t pack(std::uint64_t begin, std::uint64_t end)
+  {
+    return (begin << 32) | end;
+  }
+  static std::size_t begin(std::uint64_t b) { return b >> 32; }
+  static std::size_t end(std::uint64_t b) { return b & 0xffffffffu; }
+
+  // Up to block from the front, for the owner
+  bool take(std::size_t block, std::size_t& b, std::size_t& e)
+  {
+    std::uint64_t v = bounds.load(std::memory_order_relaxed);
+    do
+      {
+        b = begin(v);
+        e = std::min(end(v), b + block);
+        if (b >= e)
+          {
+            return false;
+          }
+      }
+    while (!bounds.compare_exchange_weak(v, pack(e, end(v)),
+                                         std::memory_order_relaxed));
+    return true;
+  }
+
+  // The back half, for a thief, if more than block is left
+  bool steal(std::size_t block, std::size_t& b, std::size_t& e)
+  {
+    std::uint64_t v = bounds.load(std::memory_order_relaxed);
+    do
+      {
+        if (end(v) - begin(v) <= block)
+          {
+            return false;
+          }
+        b = begin(v) + (end(v) - begin(v)) / 2;
+        e = end(v);
+      }
+    while (!bounds.compare_exchange_weak(v, pack(begin(v), b),
+                                         std::memory_order_relaxed));
+    return true;
+  }
+};
+
+// Calls f(begin, end) on disjoint blocks covering [0, count), using up to
+// threads threads including the caller. Each starts with an equal share
+// and takes block rows at a time from its front. A thread that runs out
+// steals the back half of the largest share left, so uneven costs per row
+// do not leave cores idle
+template <typename F>
+void parallel_blocks(std::size_t count, unsigned threads, F f,
+                     std::size_t block = 1024)
+{
+  threads = static_cast<unsigned>(
+      std::max<std::size_t>(1, std::min<std::size_t>(threads, count / block)));
+  if (threads == 1)
+    {
+      if (count)
+        {
+          f(std::size_t(0), count);
+        }
+      return;
+    }
+
+  // Offsets within a round fit the 32 bits batch_range holds each
+  const std::size_t round = std::size_t(1) << 31;
+  for (std::size_t base = 0; base < count; base += round)
+    {
+      const std::size_t n = std::min(round, count - base);
+      std::vector<batch_range> ranges(threads);
+      for (unsigned t = 0; t < threads; t++)
+        {
+          ranges[t].bounds.store(
+              batch_range::pack(n * t / threads, n * (t + 1) / threads),
+              std::memory_order_relaxed);
+        }
+
+      auto work = [&](unsigned self) {
+        std::size_t b, e;
+        for (;;)
+          {
+            while (ranges[self].take(block, b, e))
+              {
+                f(base + b, base + e);
+              }
+            // Refill from the share with the most left. Only the owner
+            // adds to a range, and only once it is empty
+            unsigned victim = self;
+            std::size_t most = block;
+            for (unsigned t = 0; t < threads; t++)
+              {
+                const std::uint64_t v =
+                    ranges[t].bounds.load(std::memory_order_relaxed);
+                const std::size_t left =
+                    batch_range::end(v) - batch_range::begin(v);
+                if (left > most)
+                  {
+                    victim = t;
+                    most = left;
+                  }
+              }
+            if (victim == self)
+              {
+                return;
+              }
+            if (ranges[victim].steal(block, b, e))
+              {
+                ranges[self].bounds.store(batch_range::pack(b, e),
+                                          std::memory_order_relaxed);
+              }
+          }
+      };
+
+      std::vector<std::thread> pool;
+      for (unsigned t = 1; t < threads; t++)
+        {
+          pool.emplace_back(work, t);
+        }
+      work(0);
+      for (std::thread& t : pool)
+        {
+          t.join();
+        }
+    }
+}
+
+// Sorts [first, last) by less, using up to threads threads. Equal shares
+// are sorted at once, then merged in pairs, half as many each round
+template <typename It, typename Less>
+void parallel_sort(It first, It last, unsigned threads, Less less)
+{
+  const std::size_t count = last - first;
+  const std::size_t shares = std::max<std::size_t>(
+      1, std::min<std::size_t>(threads, count / 1024));
+  auto bound = [=](std::size_t s) { return first + count * s / shares; };
+  parallel_blocks(shares, threads,
+                  [&](std::size_t begin, std::size_t end) {
+                    for (std::size_t s = begin; s < end; s++)
+                      {
+                        std::sort(bound(s), bound(s + 1), less);
+                      }
+                  },
+                  1);
+  for (std::size_t width = 1; width < shares; width *= 2)
+    {
+      const std::size_t pairs = (shares + 2 * width - 1) / (2 * width);
+      parallel_blocks(pairs, threads,
+                      [&](std::size_t begin, std::size_t end) {
+                        for (std::size_t p = begin; p < end; p++)
+                          {
+                            const std::size_t lo = 2 * width * p;
+                            const std::size_t mid = lo + width;
+                            if (mid < shares)
+                              {
+                                std::inplace_merge(
+                                    bound(lo), bound(mid),
+                                    bound(std::min(mid + width, shares)),
+                                    less);
+                              }
+                          }
+                      },
+                      1);
+    }
+}
+
+template <typename It>
+void parallel_sort(It first, It last, unsigned threads)
+{
+  parallel_sort(first, last, threads,
+                std::less<typename std::iterator_traits<It>::value_type>());
+}
+
+// Index in T of each of count keys, written to out. Absent keys are
+// T::fail()
+template <typename T>
+void lookup_batch(const char* const* keys, std::size_t count,
+                  std::size_t* out)
+{
+  for (std::size_t i = 0; i < count; i++)
+    {
+      out[i] = T::lookup_index(keys[i]);
+    }
+}
+
+// As above, over up to threads threads. Each writes its own blocks of out
+// without synchronisation
+template <typename T>
+void lookup_batch(const char* const* keys, std::size_t count,
+                  std::size_t* out, unsigned threads)
+{
+  parallel_blocks(count, threads, [=](std::size_t begin, std::size_t end) {
+    lookup_batch<T>(keys + begin, end - begin, out + begin);
+  });
+}
+}
+
+#endif  // BATCH_HPP
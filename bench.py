@@ -35,53 +35,316 @@ def arr_values(length):
     # Hold back 2^64-1 as a sentinel
     return [random.randint(0,pow(2,64)-2) for x in range(length+1)]
 
+def cstr(h):
+    return '"' + ''.join('\\x{0:02x}'.format(i % 256) for i in h) + '"'
+
 def print_hexlist_as_cstr(h):
-    def tohex(val, nbits = 8):
-        return hex((val + (1 << nbits)) % (1 << nbits))
+    print(cstr(h),end='')
 
-    def hexasc(s):
-        h = tohex(s)
-        return '\\x' + h[2:].zfill(2)
-    
-    print('"',end='')
-    for i in h:
-        print("{0}".format(hexasc(i)),end='')
-    print('"',end='')
-
-def write_table(name,length,minsize,maxsize):
-    potkeyset = arr_hexlist(minsize,maxsize,length)
-    potkeyset.sort()
+def random_keys(minsize, maxsize, length):
+    return arr_hexlist(minsize,maxsize,length)
+
+def encode(words):
+    return [tuple(bytearray(w, 'ascii')) for w in words]
+
+# C++ keywords, as in big_table in prefix.cpp
+cpp_keywords = [
+    "alignas", "alignof", "and", "and_eq", "asm", "auto", "bitand", "bitor",
+    "bool", "break", "case", "catch", "char", "char16_t", "char32_t",
+    "class", "compl", "concept", "const", "const_cast", "constexpr",
+    "continue", "decltype", "default", "delete", "do", "double",
+    "dynamic_cast", "else", "enum", "explicit", "export", "extern", "false",
+    "float", "for", "friend", "goto", "if", "inline", "int", "long",
+    "mutable", "namespace", "new", "noexcept", "not", "not_eq", "nullptr",
+    "operator", "or", "or_eq", "private", "protected", "public", "register",
+    "reinterpret_cast", "requires", "return", "short", "signed", "sizeof",
+    "static", "static_assert", "static_cast", "struct", "switch", "template",
+    "this", "thread_local", "throw", "true", "try", "typedef", "typeid",
+    "typename", "union", "unsigned", "using", "virtual", "void", "volatile",
+    "wchar_t", "while", "xor", "xor_eq",
+]
+
+http_headers = [
+    "accept", "accept-charset", "accept-encoding", "accept-language",
+    "accept-ranges", "access-control-allow-credentials",
+    "access-control-allow-headers", "access-control-allow-methods",
+    "access-control-allow-origin", "access-control-expose-headers",
+    "access-control-max-age", "access-control-request-headers",
+    "access-control-request-method", "age", "allow", "authorization",
+    "cache-control", "connection", "content-disposition",
+    "content-encoding", "content-language", "content-length",
+    "content-location", "content-range", "content-security-policy",
+    "content-type", "cookie", "date", "etag", "expect", "expires",
+    "forwarded", "from", "host", "if-match", "if-modified-since",
+    "if-none-match", "if-range", "if-unmodified-since", "keep-alive",
+    "last-modified", "link", "location", "max-forwards", "origin",
+    "pragma", "proxy-authenticate", "proxy-authorization", "range",
+    "referer", "retry-after", "server", "set-cookie",
+    "strict-transport-security", "te", "trailer", "transfer-encoding",
+    "upgrade", "user-agent", "vary", "via", "warning", "www-authenticate",
+    "x-content-type-options", "x-forwarded-for", "x-forwarded-host",
+    "x-forwarded-proto", "x-frame-options", "x-request-id",
+]
+
+route_segments = [
+    "api", "v1", "v2", "users", "accounts", "orders", "items", "search",
+    "admin", "settings", "profile", "billing", "invoices", "reports",
+    "metrics", "health", "status", "auth", "login", "logout", "tokens",
+    "files", "uploads", "images", "comments", "posts", "tags", "teams",
+]
+
+metric_words = [
+    ["http", "grpc", "db", "cache", "queue", "disk", "net", "cpu", "mem"],
+    ["server", "client", "pool", "worker", "shard", "replica"],
+    ["requests", "errors", "latency", "bytes", "connections", "retries",
+     "hits", "misses", "evictions"],
+    ["count", "sum", "p50", "p99", "max", "rate"],
+]
+
+def extend(words, length):
+    # Sample fixed sets down to length, or add numbered variants to reach it
+    words = list(words)
+    random.shuffle(words)
+    out = words[:length]
+    i = 0
+    while len(out) < length:
+        out.append("x{0}-{1}".format(i // len(words), words[i % len(words)]))
+        i += 1
+    return out
+
+def route_keys(length):
+    routes = set()
+    while len(routes) < length:
+        depth = random.randint(1, 5)
+        routes.add("/" + "/".join(random.choice(route_segments)
+                                  for x in range(depth)) + "/")
+    return list(routes)
+
+def metric_keys(length):
+    names = set()
+    while len(names) < length:
+        parts = [random.choice(w) for w in metric_words]
+        if len(names) >= 0.5 * len(metric_words[0]) * len(metric_words[1]) * \
+           len(metric_words[2]) * len(metric_words[3]):
+            parts.append(str(random.randint(0, length)))
+        names.add(".".join(parts))
+    return list(names)
+
+def generate_keys(kind, length, minsize, maxsize):
+    if kind == "random":
+        return random_keys(minsize, maxsize, length)
+    if kind == "keywords":
+        return encode(extend(cpp_keywords, length))
+    if kind == "http":
+        return encode(extend(http_headers, length))
+    if kind == "routes":
+        return encode(route_keys(length))
+    if kind == "metrics":
+        return encode(metric_keys(length))
+    raise ValueError(kind)
+
+def table_keys(kind, length, minsize, maxsize):
+    # Top up with more keys until the prefix free table is long enough
+    keys = prefix_free(generate_keys(kind, length, minsize, maxsize))
+    for attempt in range(10):
+        if len(keys) >= length or kind in ("keywords", "http"):
+            break
+        keys = prefix_free(keys + generate_keys(kind, length, minsize, maxsize))
+    if len(keys) > length:
+        keys = sorted(random.sample(keys, length))
+    return keys
+
+def prefix_free(potkeyset):
+    # Rows that prefix another row are dropped, as lookup on the crtp scan
+    # does not find them, and the STL map has no notion of prefix
+    potkeyset = sorted(set(potkeyset))
     keyset = []
-    for i,v in enumerate(potkeyset[:-1]):
-        if not common_prefix(potkeyset[i],potkeyset[i+1]):
+    for i,v in enumerate(potkeyset):
+        if i + 1 == len(potkeyset) or not common_prefix(v,potkeyset[i+1]):
             keyset.append(v)
-    keyset = set(keyset)
+    return keyset
 
-    badkeyset = set(arr_hexlist(minsize,maxsize,length))
-    badkeys = list(badkeyset - keyset)
-    keys = list(keyset)
-    keys.sort()
+def matches_any(keyset,x):
+    # Faster would_match_on_prefix, for large tables
+    for i in range(len(x)+1):
+        if x[:i] in keyset:
+            return True
+    return False
 
-    prekeys = []
-    misskeys = []
+def miss_keys(kind, keys, keyset, length, minsize, maxsize):
+    # Keys from the same generator that match no row
+    misses = set()
+    for attempt in range(20):
+        if len(misses) >= length or kind in ("keywords", "http"):
+            break
+        for v in generate_keys(kind, length, minsize, maxsize):
+            if not matches_any(keyset, v):
+                misses.add(v)
+    if len(misses) < length:
+        # Reverse rows, e.g. "accept" -> "tpecca", or failing that change
+        # the first character
+        for v in keys:
+            for w in (v[::-1], ((v[0] + 128) % 256 or 1,) + v[1:]):
+                if not matches_any(keyset, w):
+                    misses.add(w)
+                    break
+    misses = sorted(misses)
+    random.shuffle(misses)
+    return sorted(misses[:length])
 
-    for v in badkeys:
-        if (would_match_on_prefix(keys,v)):
-            prekeys.append(v)
+def near_miss_keys(keys, keyset, length):
+    # Keys which follow a row until the last character or two
+    near = set()
+    for v in random.sample(keys, min(length, len(keys))):
+        if len(v) > 1 and random.random() < 0.5:
+            w = v[:-1]
         else:
-            misskeys.append(v)
+            w = v[:-1] + ((v[-1] % 255) + 1,)
+        if not matches_any(keyset, w):
+            near.add(w)
+    return sorted(near)
 
-    misskeys.sort()
-    prekeys.sort()
-    
-    # Will want prefix matching keys later
-    badkeys = misskeys
-    badkeys.sort()
-    
+def zipf_weights(length, s):
+    return [1.0 / pow(rank, s) for rank in range(1, length+1)]
+
+def choose(population, count, distribution, s):
+    if not population or count == 0:
+        return []
+    if distribution == "uniform":
+        return [random.choice(population) for x in range(count)]
+    # Popularity by rank over a random permutation of the population
+    ranked = list(population)
+    random.shuffle(ranked)
+    return random.choices(ranked, weights=zipf_weights(len(ranked), s),
+                          k=count)
+
+def query_keys(keys, misses, near, args):
+    total = args.hit + args.miss + args.near_miss
+    nhit = int(round(args.queries * args.hit / total))
+    nmiss = int(round(args.queries * args.miss / total))
+    nnear = args.queries - nhit - nmiss
+    queries = (choose(keys, nhit, args.distribution, args.zipf_s) +
+               choose(misses, nmiss, args.distribution, args.zipf_s) +
+               choose(near, nnear, args.distribution, args.zipf_s))
+    random.shuffle(queries)
+    return queries
+
+def gperf_hash(keys):
+    # gperf style: length plus associated values of a few characters,
+    # searching for values that give each row its own bucket
+    positions = [0, 1, -1]
+    size = 1
+    while size < 2 * len(keys):
+        size *= 2
+    chars = []
+    for k in keys:
+        chars.append([k[p] for p in positions if -len(k) <= p < len(k)])
+    asso = [random.randrange(size) for x in range(256)]
+
+    def buckets():
+        b = {}
+        for i,k in enumerate(keys):
+            h = (len(k) + sum(asso[c] for c in chars[i])) % size
+            b.setdefault(h, []).append(i)
+        return b
+
+    b = buckets()
+    for attempt in range(200):
+        clashes = [v for v in b.values() if len(v) > 1]
+        if not clashes:
+            break
+        i = random.choice(random.choice(clashes))
+        if chars[i]:
+            asso[random.choice(chars[i])] = random.randrange(size)
+        b = buckets()
+    return positions, size, asso, b
+
+def re2c_switch(keys, vals, lo, hi, depth, indent):
+    # Nested switch on each character in turn, as a DFA generator would
+    pad = '  ' * indent
+    if hi - lo == 1:
+        tail = keys[lo][depth:]
+        test = ' && '.join('key[{0}] == {1}'.format(depth + i, cstr((c,)).replace('"',"'"))
+                           for i,c in enumerate(tail)) or 'true'
+        print('{0}return ({1}) ? {2}u : miss;'.format(pad, test, vals[lo]))
+        return
+    print('{0}switch (key[{1}])'.format(pad, depth))
+    print('{0}{{'.format(pad))
+    i = lo
+    while i < hi:
+        j = i
+        while j < hi and keys[j][depth] == keys[i][depth]:
+            j += 1
+        print("{0}case {1}:".format(pad, cstr((keys[i][depth],)).replace('"',"'")))
+        print('{0}  {{'.format(pad))
+        re2c_switch(keys, vals, i, j, depth + 1, indent + 2)
+        print('{0}  }}'.format(pad))
+        i = j
+    print('{0}default:'.format(pad))
+    print('{0}  return miss;'.format(pad))
+    print('{0}}}'.format(pad))
+
+def node_count(keys):
+    # The root and one node per distinct prefix, as crtp::node_count
+    return 1 + len(set(k[:i] for k in keys for i in range(1,len(k)+1)))
+
+def row_weights(source, name, keys, queries):
+    # How often each row is expected to match: counted in the mixed query
+    # stream, or read from the name.row.R lines of instrumented::dump
+    if source == "mixed":
+        counts = {}
+        for q in queries:
+            counts[q] = counts.get(q, 0) + 1
+        return [counts.get(k, 0) for k in keys]
+    weights = [0] * len(keys)
+    prefix = name + ".row."
+    with open(source) as f:
+        for line in f:
+            fields = line.split()
+            if len(fields) == 2 and fields[0].startswith(prefix):
+                row = int(fields[0][len(prefix):])
+                if row < len(weights):
+                    weights[row] = int(fields[1])
+    return weights
+
+def write_table(name,keys,badkeys,nearkeys,queries,weights=None):
     length = len(keys)
-    vals = arr_values(length)
+    vals = arr_values(length)[:length]
+    nodes = node_count(keys)
+
+    # Read by code_size.py
+    print("// table {0}: {1} rows, {2} nodes\n".format(name,length,nodes))
+
+    def key_array(tag,keylist):
+        print("""extern const char * const {0}_{1}_keys[] = {{""".format(name,tag))
+        for k in keylist:
+            print('  ',end='')
+            print_hexlist_as_cstr(k)
+            print(',')
+        print("""  nullptr,
+}};
+extern const std::size_t {0}_{1}_count = {2};
+""".format(name,tag,len(keylist)))
+    key_array("successful",keys)
+    key_array("failing",badkeys)
+    key_array("near_miss",nearkeys)
+    key_array("mixed",queries)
+
+    print("""static const uint64_t {0}_values[] = {{""".format(name))
+    for v in vals:
+        print("  {0}u,".format(v))
+    print("""}};
+static const uint64_t miss = std::numeric_limits<uint64_t>::max();
+
+struct cstr_less
+{{
+  bool operator()(const char * x, const char * y) const
+  {{
+    return strcmp(x,y) < 0;
+  }}
+}};
 
-    print("""#ifdef PRE
+#if defined(PRE) || defined(INTERP)
 struct {0} : prefix::crtp<{0},uint64_t>
 {{
   static constexpr element table[] = {{""".format(name))
@@ -90,14 +353,116 @@ struct {0} : prefix::crtp<{0},uint64_t>
         print("    {",end='')
         print_hexlist_as_cstr(keys[i])
         print(",{0}u}},".format(vals[i]))
-    print("""  }};
-}};
-constexpr decltype({0}::table) {0}::table;
+    print("""  };""")
+    if weights:
+        print("""  static constexpr unsigned weights[] = {""")
+        for i in range(0, length, 8):
+            print("    " + ", ".join(str(w) for w in weights[i:i+8]) + ",")
+        print("""  };""")
+    print("""}};
+constexpr decltype({0}::table) {0}::table;{2}
 static_assert({0}::ordered<0, {0}::size()>(), "Ordered");
+static_assert({0}::node_count() == {1}, "Node count");
 #endif
 
-#ifdef STL
+#ifdef INTERP
+uint64_t {0}_lookup_interp(const char * key)
+{{
+  const std::size_t index = prefix::interpreted<{0}>::lookup_index(key);
+  return (index == {0}::fail()) ? miss : {0}::table[index].value;
+}}
+
+uint64_t {0}_lookup_hybrid(const char * key)
+{{
+  const std::size_t index =
+      prefix::interpreted<{0}>::lookup_index_hybrid(key);
+  return (index == {0}::fail()) ? miss : {0}::table[index].value;
+}}
+#endif
 
+#ifdef PRE
+uint64_t {0}_lookup_prefix(const char * key)
+{{
+  auto search = {0}::lookup(key);
+  if (search == {0}::end())
+  {{
+    return miss;
+  }}
+  else
+  {{
+    return *search;
+  }}
+}}
+
+uint64_t {0}_lookup_critbit(const char * key)
+{{
+  const std::size_t index = {0}::lookup_index_critbit(key);
+  return (index == {0}::fail()) ? miss : {0}::table[index].value;
+}}
+
+uint64_t {0}_lookup_stride(const char * key)
+{{
+  const std::size_t index = {0}::lookup_index_stride(key);
+  return (index == {0}::fail()) ? miss : {0}::table[index].value;
+}}
+
+uint64_t {0}_lookup_weighted(const char * key)
+{{
+  const std::size_t index = {0}::lookup_index_weighted(key);
+  return (index == {0}::fail()) ? miss : {0}::table[index].value;
+}}
+#endif
+
+#ifdef RUNTIME
+static const std::vector<std::string> {0}_rows(
+    {0}_successful_keys, {0}_successful_keys + {0}_successful_count);
+
+// Values by row, as each table sorts its rows itself
+template <typename T>
+static std::vector<uint64_t> {0}_row_values(const T & table)
+{{
+  std::vector<uint64_t> values(table.size(), miss);
+  for (std::size_t i = 0; i < {0}_successful_count; i++)
+  {{
+    const char * key = {0}_successful_keys[i];
+    values[table.lookup_index(key, strlen(key))] = {0}_values[i];
+  }}
+  return values;
+}}
+
+static const prefix::runtime_table {0}_runtime({0}_rows);
+static const std::vector<uint64_t> {0}_runtime_values =
+    {0}_row_values({0}_runtime);
+
+static const prefix::art_table {0}_art({0}_rows);
+static const std::vector<uint64_t> {0}_art_values = {0}_row_values({0}_art);
+
+static const prefix::art_table {0}_art_blocked({0}_rows, 1,
+                                               prefix::art_table::blocked);
+static const std::vector<uint64_t> {0}_art_blocked_values =
+    {0}_row_values({0}_art_blocked);
+
+uint64_t {0}_lookup_runtime(const char * key)
+{{
+  const std::size_t index = {0}_runtime.lookup_index(key);
+  return (index == {0}_runtime.fail()) ? miss : {0}_runtime_values[index];
+}}
+
+uint64_t {0}_lookup_art(const char * key)
+{{
+  const std::size_t index = {0}_art.lookup_index(key);
+  return (index == {0}_art.fail()) ? miss : {0}_art_values[index];
+}}
+
+uint64_t {0}_lookup_art_blocked(const char * key)
+{{
+  const std::size_t index = {0}_art_blocked.lookup_index(key);
+  return (index == {0}_art_blocked.fail()) ? miss
+                                           : {0}_art_blocked_values[index];
+}}
+#endif
+
+#ifdef STL
 struct map_equal
 {{
   bool operator()(const char * x, const char * y) const
@@ -125,117 +490,287 @@ typedef std::unordered_map<const char *,uint64_t,map_hash,map_equal> map_type;
 static map_type get_stl_unordered_map_{0}()
 {{
   map_type map;
-""".format(name))
-    for i in range(length):
-        print("    map[",end="")
-        print_hexlist_as_cstr(keys[i])
-        print("] = {0}u;".format(vals[i]))
-    print("""
+  for (std::size_t i = 0; i < {0}_successful_count; i++)
+  {{
+    map[{0}_successful_keys[i]] = {0}_values[i];
+  }}
   return map;
 }}
 
 static map_type stl_map = get_stl_unordered_map_{0}();
-#endif
-""".format(name))
 
-    print("""
-#ifdef PRE
-uint64_t {0}_lookup_prefix(const char * key)
+uint64_t {0}_lookup_stl(const char * str)
 {{
-  auto search = {0}::lookup(key);
-  if (search == {0}::end())
+  auto search = stl_map.find(str);
+  if (search == stl_map.end())
   {{
-    return std::numeric_limits<uint64_t>::max();
+    return miss;
   }}
   else
   {{
-    return *search;
+    return search->second;
   }}
 }}
 #endif
-#ifdef STL
-uint64_t {0}_lookup_stl(const char * str)
+
+#ifdef MAP
+typedef std::map<const char *,uint64_t,cstr_less> ordered_map_type;
+
+static ordered_map_type get_stl_map_{0}()
 {{
-  auto search = stl_map.find(str);
-  if (search == stl_map.end())
+  ordered_map_type map;
+  for (std::size_t i = 0; i < {0}_successful_count; i++)
   {{
-    return std::numeric_limits<uint64_t>::max();
+    map[{0}_successful_keys[i]] = {0}_values[i];
   }}
-  else
+  return map;
+}}
+
+static ordered_map_type ordered_map = get_stl_map_{0}();
+
+uint64_t {0}_lookup_map(const char * str)
+{{
+  auto search = ordered_map.find(str);
+  return (search == ordered_map.end()) ? miss : search->second;
+}}
+#endif
+
+#ifdef VEC
+typedef std::vector<std::pair<const char *,uint64_t>> vector_type;
+
+static vector_type get_sorted_vector_{0}()
+{{
+  vector_type vec;
+  for (std::size_t i = 0; i < {0}_successful_count; i++)
   {{
-    return search->second;
+    vec.push_back(std::make_pair({0}_successful_keys[i], {0}_values[i]));
+  }}
+  std::sort(vec.begin(), vec.end(), [](const vector_type::value_type & x,
+                                       const vector_type::value_type & y)
+            {{ return cstr_less()(x.first, y.first); }});
+  return vec;
+}}
+
+static vector_type sorted_vector = get_sorted_vector_{0}();
+
+// No row prefixes another, so a row which prefixes the key is the last
+// row not greater than it
+uint64_t {0}_lookup_vector(const char * str)
+{{
+  auto search = std::upper_bound(
+      sorted_vector.begin(), sorted_vector.end(), str,
+      [](const char * x, const vector_type::value_type & y)
+      {{ return cstr_less()(x, y.first); }});
+  if (search == sorted_vector.begin())
+  {{
+    return miss;
   }}
+  --search;
+  const std::size_t len = strlen(search->first);
+  return (strncmp(str, search->first, len) == 0) ? search->second : miss;
+}}
+#endif
+
+#ifdef LIN
+static const std::size_t {0}_sizes[] = {{""".format(name,nodes,
+        "\nconstexpr decltype({0}::weights) {0}::weights;".format(name)
+        if weights else ""))
+    for k in keys:
+        print("  {0},".format(len(k)))
+    print("""}};
+
+uint64_t {0}_lookup_linear(const char * str)
+{{
+  for (std::size_t i = 0; i < {0}_successful_count; i++)
+  {{
+    if (strncmp(str, {0}_successful_keys[i], {0}_sizes[i]) == 0)
+    {{
+      return {0}_values[i];
+    }}
+  }}
+  return miss;
 }}
 #endif
 """.format(name))
 
-    if True:
-        print("""// Correctness sanity check
-    void {0}_sanity()
-{{""".format(name))
-        for i in range(length):
-            print('''  {
-    const char * key = ''',end='')
-            print_hexlist_as_cstr(keys[i])
-            print('''; // Present
-#ifdef PRE
-    assert({1}u == {0}_lookup_prefix(key));
+    positions, size, asso, buckets = gperf_hash(keys)
+    order = []
+    starts = []
+    for h in range(size):
+        starts.append(len(order))
+        order += buckets.get(h, [])
+    starts.append(len(order))
+    print("""#ifdef GPERF
+// Largest bucket holds {1} rows
+static const unsigned {0}_asso[256] = {{""".format(
+        name, max(len(v) for v in buckets.values())))
+    for i in range(0, 256, 8):
+        print("  " + ", ".join(str(a) for a in asso[i:i+8]) + ",")
+    print("""}};
+static const unsigned {0}_bucket[] = {{""".format(name))
+    for i in range(0, len(starts), 8):
+        print("  " + ", ".join(str(a) for a in starts[i:i+8]) + ",")
+    print("""}};
+static const unsigned {0}_bucket_row[] = {{""".format(name))
+    for i in range(0, len(order), 8):
+        print("  " + ", ".join(str(a) for a in order[i:i+8]) + ",")
+    print("""  0,
+}};
+
+uint64_t {0}_lookup_gperf(const char * str)
+{{
+  const std::size_t len = strlen(str);
+  std::size_t hash = len;""".format(name))
+    for p in positions:
+        if p >= 0:
+            print("  if (len > {1}) hash += {0}_asso[(unsigned char)str[{1}]];".format(name, p))
+        else:
+            print("  if (len >= {1}) hash += {0}_asso[(unsigned char)str[len - {1}]];".format(name, -p))
+    print("""  hash &= {1};
+  for (unsigned i = {0}_bucket[hash]; i < {0}_bucket[hash + 1]; i++)
+  {{
+    const unsigned row = {0}_bucket_row[i];
+    if (strcmp(str, {0}_successful_keys[row]) == 0)
+    {{
+      return {0}_values[row];
+    }}
+  }}
+  return miss;
+}}
 #endif
-#ifdef STL
-    assert({1}u == {0}_lookup_stl(key));
+
+#ifdef RE2C
+uint64_t {0}_lookup_re2c(const char * key)
+{{""".format(name, size - 1))
+    re2c_switch(keys, vals, 0, length, 0, 1)
+    print("""}}
 #endif
-  }}'''.format(name,vals[i]))
 
-        for i in range(len(badkeys)):
-            print('''  {
-    const char * key = ''',end='')
-            print_hexlist_as_cstr(badkeys[i])
-            print('''; // Absent
+// Correctness sanity check
+static void {0}_check(const char * key, uint64_t expect)
+{{
+  (void)key;
+  (void)expect;
 #ifdef PRE
-    assert({1}u == {0}_lookup_prefix(key));
+  assert(expect == {0}_lookup_prefix(key));
+  assert(expect == {0}_lookup_critbit(key));
+  assert(expect == {0}_lookup_stride(key));
+  assert(expect == {0}_lookup_weighted(key));
+#endif
+#ifdef INTERP
+  assert(expect == {0}_lookup_interp(key));
+  assert(expect == {0}_lookup_hybrid(key));
+#endif
+#ifdef RUNTIME
+  assert(expect == {0}_lookup_runtime(key));
+  assert(expect == {0}_lookup_art(key));
+  assert(expect == {0}_lookup_art_blocked(key));
 #endif
 #ifdef STL
-    assert({1}u == {0}_lookup_stl(key));
+  assert(expect == {0}_lookup_stl(key));
+#endif
+#ifdef MAP
+  assert(expect == {0}_lookup_map(key));
+#endif
+#ifdef VEC
+  assert(expect == {0}_lookup_vector(key));
+#endif
+#ifdef LIN
+  assert(expect == {0}_lookup_linear(key));
+#endif
+#ifdef GPERF
+  assert(expect == {0}_lookup_gperf(key));
 #endif
-  }}'''.format(name,pow(2,64)-1))
-        
-        print('}\n')
+#ifdef RE2C
+  assert(expect == {0}_lookup_re2c(key));
+#endif
+}}
 
-    
-    def lookup_every_string(tag,func,keylist):
-        print("""void {0}_lookup_every_{1}_{2}()
-{{""".format(name,tag,func))
-        for k in keylist:
-            print('''  value_sink({0}_lookup_{2}('''.format(name,tag, func),end='')
-            print_hexlist_as_cstr(k)
-            print('''));''')
-        print('}\n')
-    print('#ifdef PRE')
-    lookup_every_string("successful","prefix",keys)
-    lookup_every_string("failing","prefix",badkeys)
-    print('#endif //PRE')
-    print('#ifdef STL')
-    lookup_every_string("successful","stl",keys)
-    lookup_every_string("failing","stl",badkeys)
-    print('#endif //STL')
-
-
-minsize = 1
-maxsize = 32
-length = 50
+void {0}_sanity()
+{{
+  for (std::size_t i = 0; i < {0}_successful_count; i++)
+  {{
+    {0}_check({0}_successful_keys[i], {0}_values[i]); // Present
+  }}
+  for (std::size_t i = 0; i < {0}_failing_count; i++)
+  {{
+    {0}_check({0}_failing_keys[i], miss); // Absent
+  }}
+  for (std::size_t i = 0; i < {0}_near_miss_count; i++)
+  {{
+    {0}_check({0}_near_miss_keys[i], miss); // Absent
+  }}
+}}
+""".format(name))
+
+
+import argparse
+
+parser = argparse.ArgumentParser(
+    description="Generate bench.cpp, a table and queries for bench_main.cpp")
+parser.add_argument("--seed", type=int, default=1,
+                    help="random seed, for repeatable corpora")
+parser.add_argument("--keys", default="random",
+                    choices=["random", "keywords", "http", "routes", "metrics"],
+                    help="kind of key in the table")
+parser.add_argument("--size", type=int, default=50,
+                    help="number of rows (10 to 100000), fewer for keywords "
+                    "and http once rows that prefix others are removed")
+parser.add_argument("--minsize", type=int, default=1,
+                    help="shortest random key")
+parser.add_argument("--maxsize", type=int, default=32,
+                    help="longest random key")
+parser.add_argument("--queries", type=int, default=1000,
+                    help="length of the mixed query stream")
+parser.add_argument("--distribution", default="uniform",
+                    choices=["uniform", "zipf"],
+                    help="how often each key appears in the mixed queries")
+parser.add_argument("--zipf-s", type=float, default=1.0,
+                    help="zipf exponent")
+parser.add_argument("--hit", type=float, default=0.5,
+                    help="share of mixed queries which match a row")
+parser.add_argument("--miss", type=float, default=0.25,
+                    help="share of mixed queries which match nothing")
+parser.add_argument("--near-miss", type=float, default=0.25,
+                    help="share of mixed queries which almost match a row")
+parser.add_argument("--weights", metavar="SOURCE",
+                    help="give the prefix table row weights, counted in the "
+                    "mixed queries if SOURCE is mixed, else read from a "
+                    "prefix::instrumented dump of table gen")
+args = parser.parse_args()
+
+if not 10 <= args.size <= 100000:
+    parser.error("--size must be between 10 and 100000")
+if args.hit + args.miss + args.near_miss <= 0:
+    parser.error("--hit, --miss and --near-miss must not all be zero")
+
+random.seed(args.seed)
+
+keys = table_keys(args.keys,args.size,args.minsize,args.maxsize)
+keyset = set(keys)
+misses = miss_keys(args.keys,keys,keyset,args.size,args.minsize,args.maxsize)
+near = near_miss_keys(keys,keyset,args.size)
+queries = query_keys(keys,misses,near,args)
 
 print('''#include "prefix.hpp"
+#include "interpret.hpp"
+#include "runtime.hpp"
+#include "art.hpp"
+#include <algorithm>
 #include <cstring>
 #include <cassert>
+#include <limits>
+#include <map>
+#include <string>
 #include <unordered_map>
+#include <vector>
 
-#ifndef PRE
-#ifndef STL
-#error "require at least one of PRE and STL to be defined"
+#if !defined(PRE) && !defined(STL) && !defined(MAP) && !defined(VEC) && \\
+    !defined(LIN) && !defined(GPERF) && !defined(RE2C) && \\
+    !defined(INTERP) && !defined(RUNTIME)
+#error "require one of PRE, STL, MAP, VEC, LIN, GPERF, RE2C, INTERP, RUNTIME"
 #endif
-#endif
-
-void value_sink(uint64_t);
 
 ''')
-write_table("gen",length,minsize,maxsize)
+weights = row_weights(args.weights,"gen",keys,queries) if args.weights else None
+write_table("gen",keys,misses,near,queries,weights)
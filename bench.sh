@@ -1,13 +1,13 @@
 #!/bin/bash
-clear
-make bench
+# Usage: bench.sh [--json] [bench_main options]
+# Text output by default, one JSON document per variant with --json
+make bench || exit 1
 
-for i in stl_fail_bench.exe pre_fail_bench.exe stl_pass_bench.exe pre_pass_bench.exe; do
-    echo $i
-    for j in 1 2 3; do
-	time ./$i
-    done
+for i in stl_bench.exe pre_bench.exe; do
+    if [ "$1" != "--json" ]; then
+	echo $i
+    fi
+    ./$i "$@" || exit 1
 done
 
 exit 0
-    
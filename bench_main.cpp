@@ -1,43 +1,748 @@
+#include "batch.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
 #include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <vector>
 
-void gen_sanity();
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+// Generated by bench.py
+extern const char* const gen_successful_keys[];
+extern const std::size_t gen_successful_count;
+extern const char* const gen_failing_keys[];
+extern const std::size_t gen_failing_count;
+extern const char* const gen_near_miss_keys[];
+extern const std::size_t gen_near_miss_count;
+extern const char* const gen_mixed_keys[];
+extern const std::size_t gen_mixed_count;
 
 #ifdef PRE
-void gen_lookup_every_successful_prefix();
-void gen_lookup_every_failing_prefix();
+uint64_t gen_lookup_prefix(const char* key);
+uint64_t gen_lookup_critbit(const char* key);
+uint64_t gen_lookup_stride(const char* key);
+uint64_t gen_lookup_weighted(const char* key);
+#endif
+#ifdef INTERP
+uint64_t gen_lookup_interp(const char* key);
+uint64_t gen_lookup_hybrid(const char* key);
+#endif
+#ifdef RUNTIME
+uint64_t gen_lookup_runtime(const char* key);
+uint64_t gen_lookup_art(const char* key);
+uint64_t gen_lookup_art_blocked(const char* key);
 #endif
 #ifdef STL
-void gen_lookup_every_successful_stl();
-void gen_lookup_every_failing_stl();
+uint64_t gen_lookup_stl(const char* key);
+#endif
+#ifdef MAP
+uint64_t gen_lookup_map(const char* key);
+#endif
+#ifdef VEC
+uint64_t gen_lookup_vector(const char* key);
+#endif
+#ifdef LIN
+uint64_t gen_lookup_linear(const char* key);
+#endif
+#ifdef GPERF
+uint64_t gen_lookup_gperf(const char* key);
+#endif
+#ifdef RE2C
+uint64_t gen_lookup_re2c(const char* key);
 #endif
 
-#if defined (PRE) && defined (STL)
 void gen_sanity();
-#endif
 
-void value_sink(uint64_t) {}
+namespace
+{
+typedef uint64_t (*lookup_fn)(const char*);
+typedef std::chrono::steady_clock bench_clock;
 
-int main()
+struct variant
 {
-#if defined (PRE) && defined (STL)
-  gen_sanity();
-#endif
-  
-  for (volatile int i = 0; i < 1000000; i++)
-    {
+  const char* name;
+  lookup_fn fn;
+};
+
+const variant variants[] = {
 #ifdef PRE
-#ifdef FAILING
-      gen_lookup_every_failing_prefix();
-#else
-      gen_lookup_every_successful_prefix();
+    {"pre", gen_lookup_prefix},
+    {"critbit", gen_lookup_critbit},
+    {"stride", gen_lookup_stride},
+    {"weighted", gen_lookup_weighted},
+#endif
+#ifdef INTERP
+    {"interp", gen_lookup_interp},
+    {"hybrid", gen_lookup_hybrid},
 #endif
+#ifdef RUNTIME
+    {"runtime", gen_lookup_runtime},
+    {"art", gen_lookup_art},
+    {"blocked", gen_lookup_art_blocked},
 #endif
 #ifdef STL
-#ifdef FAILING
-      gen_lookup_every_failing_stl();
+    {"stl", gen_lookup_stl},
+#endif
+#ifdef MAP
+    {"map", gen_lookup_map},
+#endif
+#ifdef VEC
+    {"vector", gen_lookup_vector},
+#endif
+#ifdef LIN
+    {"linear", gen_lookup_linear},
+#endif
+#ifdef GPERF
+    {"gperf", gen_lookup_gperf},
+#endif
+#ifdef RE2C
+    {"re2c", gen_lookup_re2c},
+#endif
+};
+
+struct workload
+{
+  const char* name;
+  std::vector<const char*> keys;
+};
+
+struct options
+{
+  unsigned warmup = 3;
+  unsigned repetitions = 15;
+  std::size_t samples = 100000;
+  double min_seconds = 0.01;
+  bool json = false;
+  bool check = false;
+  bool counters = false;
+  unsigned threads = 0;
+  bool batch = false;
+};
+
+// Hardware events counted per lookup with --counters
+enum
+{
+  cycles,
+  instructions,
+  branch_misses,
+  l1i_misses,
+  l1d_misses,
+  event_count
+};
+
+const char* const event_names[event_count] = {
+    "cycles", "instructions", "branch_misses", "l1i_misses", "l1d_misses"};
+
+struct result
+{
+  const char* variant;
+  const char* workload;
+  std::size_t keys;
+  double ns_per_lookup;
+  double lookups_per_second;
+  double median_ns;
+  double p99_ns;
+  double events[event_count];  // Per lookup, negative if not counted
+};
+
+// Scaling of one variant and workload over a number of threads
+struct scaling
+{
+  const char* variant;
+  const char* workload;
+  unsigned threads;
+  double lookups_per_second;  // All threads together
+  double ns_per_lookup;       // Median of the per thread latencies
+  double worst_ns_per_lookup; // Slowest thread
+};
+
+// One per thread, so the threads of a scaling run do not share it
+thread_local volatile uint64_t sink;
+
+double seconds(bench_clock::time_point start, bench_clock::time_point end)
+{
+  return std::chrono::duration<double>(end - start).count();
+}
+
+// Look up every key, passes times over. Returns elapsed seconds
+double run(lookup_fn fn, const std::vector<const char*>& keys, unsigned passes)
+{
+  uint64_t acc = 0;
+  const bench_clock::time_point start = bench_clock::now();
+  for (unsigned p = 0; p < passes; p++)
+    {
+      for (const char* key : keys)
+        {
+          acc += fn(key);
+        }
+    }
+  const bench_clock::time_point end = bench_clock::now();
+  sink = acc;
+  return seconds(start, end);
+}
+
+// Counters for this thread, user space only. Each event is opened on its
+// own so that one the machine lacks, commonly L1i, does not lose the rest
+class perf_counters
+{
+ public:
+  perf_counters()
+  {
+    for (int& fd : fds)
+      {
+        fd = -1;
+      }
+#ifdef __linux__
+    const uint64_t cache_read_miss =
+        (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+        (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+    open(cycles, PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES);
+    open(instructions, PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS);
+    open(branch_misses, PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES);
+    open(l1i_misses, PERF_TYPE_HW_CACHE,
+         PERF_COUNT_HW_CACHE_L1I | cache_read_miss);
+    open(l1d_misses, PERF_TYPE_HW_CACHE,
+         PERF_COUNT_HW_CACHE_L1D | cache_read_miss);
+#endif
+  }
+
+  ~perf_counters()
+  {
+#ifdef __linux__
+    for (int fd : fds)
+      {
+        if (fd >= 0)
+          {
+            close(fd);
+          }
+      }
+#endif
+  }
+
+  perf_counters(const perf_counters&) = delete;
+  perf_counters& operator=(const perf_counters&) = delete;
+
+  bool any() const
+  {
+    return std::any_of(fds, fds + event_count, [](int fd) { return fd >= 0; });
+  }
+
+  void start()
+  {
+#ifdef __linux__
+    for (int fd : fds)
+      {
+        if (fd >= 0)
+          {
+            ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+            ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+          }
+      }
+#endif
+  }
+
+  // Stop counting and write each count divided by n, or -1 if unavailable
+  void stop(double n, double* events)
+  {
+    for (int e = 0; e < event_count; e++)
+      {
+        events[e] = -1;
+#ifdef __linux__
+        if (fds[e] < 0)
+          {
+            continue;
+          }
+        ioctl(fds[e], PERF_EVENT_IOC_DISABLE, 0);
+        // Scaled up if the kernel multiplexed the counter
+        uint64_t value[3];
+        if (read(fds[e], value, sizeof(value)) == sizeof(value) && value[2])
+          {
+            events[e] = double(value[0]) * (double(value[1]) / value[2]) / n;
+          }
 #else
-      gen_lookup_every_successful_stl();
+        (void)n;
 #endif
+      }
+  }
+
+ private:
+#ifdef __linux__
+  void open(int e, uint32_t type, uint64_t config)
+  {
+    perf_event_attr attr;
+    std::memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = type;
+    attr.config = config;
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.read_format =
+        PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+    fds[e] = static_cast<int>(
+        syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0));
+  }
 #endif
+
+  int fds[event_count];
+};
+
+double percentile(std::vector<double>& sorted, double p)
+{
+  return sorted.empty() ? 0 : sorted[static_cast<std::size_t>(
+                                  p * (sorted.size() - 1))];
+}
+
+// Cost of reading the clock, subtracted from per call latencies
+double clock_overhead_ns()
+{
+  std::vector<double> d(1000);
+  for (double& x : d)
+    {
+      const bench_clock::time_point start = bench_clock::now();
+      const bench_clock::time_point end = bench_clock::now();
+      x = 1e9 * seconds(start, end);
+    }
+  std::sort(d.begin(), d.end());
+  return percentile(d, 0.5);
+}
+
+result measure(const variant& v, const workload& w, const options& opt,
+               double overhead, perf_counters& counters)
+{
+  result r = {v.name, w.name, w.keys.size(), 0, 0, 0, 0, {}};
+  std::fill(r.events, r.events + event_count, -1.0);
+  if (w.keys.empty())
+    {
+      return r;
+    }
+
+  // Warm up caches and predictors, and find enough passes that a single
+  // repetition is long enough to time
+  unsigned passes = 1;
+  for (unsigned i = 0; i < opt.warmup; i++)
+    {
+      while (run(v.fn, w.keys, passes) < opt.min_seconds)
+        {
+          passes *= 2;
+        }
+    }
+
+  std::vector<double> reps(opt.repetitions);
+  for (double& t : reps)
+    {
+      t = run(v.fn, w.keys, passes) / (double(passes) * w.keys.size());
+    }
+  std::sort(reps.begin(), reps.end());
+  r.ns_per_lookup = 1e9 * percentile(reps, 0.5);
+  r.lookups_per_second = 1e9 / r.ns_per_lookup;
+
+  if (opt.counters)
+    {
+      counters.start();
+      run(v.fn, w.keys, passes);
+      counters.stop(double(passes) * w.keys.size(), r.events);
+    }
+
+  // Per call latency, limited by the resolution of the clock
+  std::vector<double> calls(opt.samples);
+  uint64_t acc = 0;
+  for (std::size_t i = 0; i < calls.size(); i++)
+    {
+      const char* key = w.keys[i % w.keys.size()];
+      const bench_clock::time_point start = bench_clock::now();
+      acc += v.fn(key);
+      const bench_clock::time_point end = bench_clock::now();
+      calls[i] = std::max(0.0, 1e9 * seconds(start, end) - overhead);
+    }
+  sink = acc;
+  std::sort(calls.begin(), calls.end());
+  r.median_ns = percentile(calls, 0.5);
+  r.p99_ns = percentile(calls, 0.99);
+  return r;
+}
+
+workload make_workload(const char* name, const char* const* keys,
+                       std::size_t count)
+{
+  workload w = {name, std::vector<const char*>(keys, keys + count)};
+  return w;
+}
+
+// The mixed stream is drawn by bench.py from the others, with the hit
+// and miss ratios and key popularity given to it
+std::vector<workload> workloads()
+{
+  std::vector<workload> w;
+  w.push_back(make_workload("hit", gen_successful_keys, gen_successful_count));
+  w.push_back(make_workload("miss", gen_failing_keys, gen_failing_count));
+  w.push_back(
+      make_workload("nearmiss", gen_near_miss_keys, gen_near_miss_count));
+  w.push_back(make_workload("mixed", gen_mixed_keys, gen_mixed_count));
+  return w;
+}
+
+// Pin the calling thread to a core, where the platform allows it
+void pin(unsigned core)
+{
+#ifdef __linux__
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  CPU_SET(core, &set);
+  pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+#else
+  (void)core;
+#endif
+}
+
+// Every thread looks up the whole workload, passes times over, starting
+// together. Each reports its own time, the aggregate rate is taken over
+// the wall time of the slowest
+scaling measure_threads(const variant& v, const workload& w,
+                        const options& opt, unsigned threads, unsigned passes)
+{
+  const unsigned cores = std::max(1u, std::thread::hardware_concurrency());
+  std::vector<double> rate(opt.repetitions);
+  std::vector<double> per_thread;
+  std::vector<double> worst(opt.repetitions);
+  for (unsigned rep = 0; rep < opt.repetitions; rep++)
+    {
+      std::atomic<unsigned> ready(0);
+      std::atomic<bool> go(false);
+      std::vector<double> elapsed(threads);
+      std::vector<std::thread> pool;
+      for (unsigned t = 0; t < threads; t++)
+        {
+          pool.push_back(std::thread([&, t] {
+            pin(t % cores);
+            run(v.fn, w.keys, 1);
+            ready++;
+            while (!go)
+              {
+                std::this_thread::yield();
+              }
+            elapsed[t] = run(v.fn, w.keys, passes);
+          }));
+        }
+      while (ready != threads)
+        {
+          std::this_thread::yield();
+        }
+      const bench_clock::time_point start = bench_clock::now();
+      go = true;
+      for (std::thread& t : pool)
+        {
+          t.join();
+        }
+      const double wall = seconds(start, bench_clock::now());
+
+      const double lookups = double(passes) * w.keys.size();
+      rate[rep] = threads * lookups / wall;
+      for (double e : elapsed)
+        {
+          per_thread.push_back(1e9 * e / lookups);
+        }
+      worst[rep] = 1e9 * *std::max_element(elapsed.begin(), elapsed.end()) /
+                   lookups;
+    }
+
+  std::sort(rate.begin(), rate.end());
+  std::sort(per_thread.begin(), per_thread.end());
+  std::sort(worst.begin(), worst.end());
+  scaling r = {v.name,
+               w.name,
+               threads,
+               percentile(rate, 0.5),
+               percentile(per_thread, 0.5),
+               percentile(worst, 0.5)};
+  return r;
+}
+
+// The workload repeated passes times as one batch, split between threads
+// by parallel_blocks as lookup_batch does. Per lookup cost is core time,
+// flat while scaling is linear
+scaling measure_batch(const variant& v, const workload& w,
+                      const options& opt, unsigned threads, unsigned passes)
+{
+  std::vector<const char*> keys;
+  for (unsigned p = 0; p < passes; p++)
+    {
+      keys.insert(keys.end(), w.keys.begin(), w.keys.end());
+    }
+  std::vector<uint64_t> out(keys.size());
+  std::vector<double> rate(opt.repetitions);
+  for (unsigned rep = 0; rep < opt.repetitions; rep++)
+    {
+      const bench_clock::time_point start = bench_clock::now();
+      prefix::parallel_blocks(keys.size(), threads,
+                              [&](std::size_t begin, std::size_t end) {
+                                for (std::size_t i = begin; i < end; i++)
+                                  {
+                                    out[i] = v.fn(keys[i]);
+                                  }
+                              });
+      rate[rep] = keys.size() / seconds(start, bench_clock::now());
+    }
+  sink = out[0];
+
+  std::sort(rate.begin(), rate.end());
+  const double median = percentile(rate, 0.5);
+  scaling r = {v.name, w.name, threads, median, 1e9 * threads / median,
+               1e9 * threads / rate[0]};
+  return r;
+}
+
+// Thread counts 1, 2, 4 ... up to and including the maximum
+std::vector<scaling> measure_scaling(const variant& v, const workload& w,
+                                     const options& opt)
+{
+  std::vector<scaling> results;
+  if (w.keys.empty())
+    {
+      return results;
+    }
+
+  // Passes for a single thread repetition to be long enough to time
+  unsigned passes = 1;
+  while (run(v.fn, w.keys, passes) < opt.min_seconds)
+    {
+      passes *= 2;
+    }
+
+  for (unsigned threads = 1;; threads *= 2)
+    {
+      threads = std::min(threads, opt.threads);
+      results.push_back(opt.batch
+                            ? measure_batch(v, w, opt, threads, passes)
+                            : measure_threads(v, w, opt, threads, passes));
+      if (threads == opt.threads)
+        {
+          return results;
+        }
+    }
+}
+
+void print_text(const std::vector<scaling>& results)
+{
+  std::printf("%-8s %-8s %7s %14s %12s %12s\n", "variant", "workload",
+              "threads", "lookups/s", "ns/lookup", "worst ns");
+  for (const scaling& r : results)
+    {
+      std::printf("%-8s %-8s %7u %14.0f %12.2f %12.2f\n", r.variant,
+                  r.workload, r.threads, r.lookups_per_second, r.ns_per_lookup,
+                  r.worst_ns_per_lookup);
+    }
+}
+
+void print_json(const std::vector<scaling>& results, const options& opt)
+{
+  std::printf("{\n  \"repetitions\": %u,\n  \"scaling\": [\n",
+              opt.repetitions);
+  for (std::size_t i = 0; i < results.size(); i++)
+    {
+      const scaling& r = results[i];
+      std::printf("    {\"variant\": \"%s\", \"workload\": \"%s\", "
+                  "\"threads\": %u, \"lookups_per_second\": %.0f, "
+                  "\"ns_per_lookup\": %.3f, "
+                  "\"worst_ns_per_lookup\": %.3f}%s\n",
+                  r.variant, r.workload, r.threads, r.lookups_per_second,
+                  r.ns_per_lookup, r.worst_ns_per_lookup,
+                  (i + 1 < results.size()) ? "," : "");
+    }
+  std::printf("  ]\n}\n");
+}
+
+void print_text(const std::vector<result>& results, const options& opt)
+{
+  std::printf("%-8s %-8s %6s %12s %14s %10s %10s", "variant", "workload",
+              "keys", "ns/lookup", "lookups/s", "median ns", "p99 ns");
+  if (opt.counters)
+    {
+      std::printf(" %8s %8s %8s %8s %8s", "cycles", "instr", "br-miss",
+                  "L1i-miss", "L1d-miss");
+    }
+  std::printf("\n");
+  for (const result& r : results)
+    {
+      std::printf("%-8s %-8s %6zu %12.2f %14.0f %10.1f %10.1f", r.variant,
+                  r.workload, r.keys, r.ns_per_lookup, r.lookups_per_second,
+                  r.median_ns, r.p99_ns);
+      for (int e = 0; opt.counters && e < event_count; e++)
+        {
+          if (r.events[e] < 0)
+            {
+              std::printf(" %8s", "-");
+            }
+          else
+            {
+              std::printf(" %8.2f", r.events[e]);
+            }
+        }
+      std::printf("\n");
+    }
+}
+
+void print_json(const std::vector<result>& results, const options& opt)
+{
+  std::printf("{\n  \"warmup\": %u,\n  \"repetitions\": %u,\n"
+              "  \"samples\": %zu,\n  \"results\": [\n",
+              opt.warmup, opt.repetitions, opt.samples);
+  for (std::size_t i = 0; i < results.size(); i++)
+    {
+      const result& r = results[i];
+      std::printf("    {\"variant\": \"%s\", \"workload\": \"%s\", "
+                  "\"keys\": %zu, \"ns_per_lookup\": %.3f, "
+                  "\"lookups_per_second\": %.0f, \"median_ns\": %.1f, "
+                  "\"p99_ns\": %.1f",
+                  r.variant, r.workload, r.keys, r.ns_per_lookup,
+                  r.lookups_per_second, r.median_ns, r.p99_ns);
+      // Per lookup, null for an event that could not be counted
+      for (int e = 0; opt.counters && e < event_count; e++)
+        {
+          if (r.events[e] < 0)
+            {
+              std::printf(", \"%s\": null", event_names[e]);
+            }
+          else
+            {
+              std::printf(", \"%s\": %.3f", event_names[e], r.events[e]);
+            }
+        }
+      std::printf("}%s\n", (i + 1 < results.size()) ? "," : "");
+    }
+  std::printf("  ]\n}\n");
+}
+
+bool parse(int argc, char** argv, options& opt)
+{
+  for (int i = 1; i < argc; i++)
+    {
+      const bool more = i + 1 < argc;
+      if (!std::strcmp(argv[i], "--json"))
+        {
+          opt.json = true;
+        }
+      else if (!std::strcmp(argv[i], "--check"))
+        {
+          opt.check = true;
+        }
+      else if (!std::strcmp(argv[i], "--counters"))
+        {
+          opt.counters = true;
+        }
+      else if (!std::strcmp(argv[i], "--batch"))
+        {
+          opt.batch = true;
+        }
+      else if (more && !std::strcmp(argv[i], "--warmup"))
+        {
+          opt.warmup = std::atoi(argv[++i]);
+        }
+      else if (more && !std::strcmp(argv[i], "--repetitions"))
+        {
+          opt.repetitions = std::max(1, std::atoi(argv[++i]));
+        }
+      else if (more && !std::strcmp(argv[i], "--threads"))
+        {
+          opt.threads = std::max(1, std::atoi(argv[++i]));
+        }
+      else if (more && !std::strcmp(argv[i], "--samples"))
+        {
+          opt.samples = std::strtoul(argv[++i], nullptr, 10);
+        }
+      else
+        {
+          std::fprintf(stderr,
+                       "Usage: %s [--json] [--check] [--counters] "
+                       "[--warmup N] [--repetitions N] [--samples N] "
+                       "[--threads N [--batch]]\n",
+                       argv[0]);
+          return false;
+        }
+    }
+  // Counters are opened for the calling thread only
+  if (opt.counters && opt.threads)
+    {
+      std::fprintf(stderr, "%s: --counters cannot be used with --threads\n",
+                   argv[0]);
+      return false;
+    }
+  return true;
+}
+}
+
+int main(int argc, char** argv)
+{
+  options opt;
+  if (!parse(argc, argv, opt))
+    {
+      return 1;
+    }
+
+  gen_sanity();
+  if (opt.check)
+    {
+      return 0;
+    }
+
+  if (opt.threads)
+    {
+      std::vector<scaling> results;
+      for (const workload& w : workloads())
+        {
+          for (const variant& v : variants)
+            {
+              const std::vector<scaling> r = measure_scaling(v, w, opt);
+              results.insert(results.end(), r.begin(), r.end());
+            }
+        }
+      if (opt.json)
+        {
+          print_json(results, opt);
+        }
+      else
+        {
+          print_text(results);
+        }
+      return 0;
+    }
+
+  const double overhead = clock_overhead_ns();
+  perf_counters counters;
+  if (opt.counters && !counters.any())
+    {
+      std::fprintf(stderr, "Hardware counters unavailable, see "
+                           "/proc/sys/kernel/perf_event_paranoid\n");
+    }
+  std::vector<result> results;
+  for (const workload& w : workloads())
+    {
+      for (const variant& v : variants)
+        {
+          results.push_back(measure(v, w, opt, overhead, counters));
+        }
+    }
+
+  if (opt.json)
+    {
+      print_json(results, opt);
+    }
+  else
+    {
+      print_text(results, opt);
     }
+  return 0;
 }
@@ -0,0 +1,278 @@
+// Time and heap taken to build runtime tables from many metric names.
+// Peak is the most heap held at once while building, beyond the keys,
+// and retained what the finished table keeps. art_table is also built
+// over --threads threads. Then lookups of every key in a random order are
+// timed for each art_table layout, with the cache lines each one reads
+//   build_bench.exe [--keys N] [--threads N] [--repetitions N] [--json]
+#include "art.hpp"
+#include "runtime.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <malloc.h>
+
+namespace
+{
+std::atomic<std::size_t> live(0);
+std::atomic<std::size_t> peak(0);
+}
+
+// Not inlined, so GCC does not pair malloc in one with free in the other
+__attribute__((noinline)) void* operator new(std::size_t n)
+{
+  void* p = std::malloc(n ? n : 1);
+  if (!p)
+    {
+      throw std::bad_alloc();
+    }
+  const std::size_t now = live += malloc_usable_size(p);
+  for (std::size_t high = peak; now > high && !peak.compare_exchange_weak(
+                                                  high, now);)
+    {
+    }
+  return p;
+}
+
+void* operator new(std::size_t n, const std::nothrow_t&) noexcept
+{
+  try
+    {
+      return operator new(n);
+    }
+  catch (const std::bad_alloc&)
+    {
+      return nullptr;
+    }
+}
+
+__attribute__((noinline)) void operator delete(void* p) noexcept
+{
+  if (p)
+    {
+      live -= malloc_usable_size(p);
+      std::free(p);
+    }
+}
+
+namespace
+{
+typedef std::chrono::steady_clock bench_clock;
+
+struct options
+{
+  std::size_t keys = 1000000;
+  unsigned threads = std::max(1u, std::thread::hardware_concurrency());
+  unsigned repetitions = 3;
+  bool json = false;
+};
+
+struct result
+{
+  const char* name;
+  unsigned threads;
+  double seconds;  // Fastest build
+  std::size_t peak;
+  std::size_t retained;
+  std::size_t rows;
+};
+
+// Lookups in one layout of art_table
+struct probe
+{
+  const char* layout;
+  std::size_t bytes;
+  double ns_per_lookup;  // Fastest pass
+  double lines_per_lookup;
+};
+
+volatile std::size_t sink;
+
+probe measure_lookups(const char* name, prefix::art_table::layout order,
+                      const std::vector<std::string>& keys,
+                      const options& opt)
+{
+  const prefix::art_table table(keys, opt.threads, order);
+  // Shuffled, so a lookup finds little of the last one's path in cache
+  std::vector<const char*> shuffled;
+  for (const std::string& k : keys)
+    {
+      shuffled.push_back(k.c_str());
+    }
+  std::shuffle(shuffled.begin(), shuffled.end(), std::mt19937(1));
+
+  probe p = {name, table.bytes(), 0, 0};
+  for (unsigned i = 0; i < opt.repetitions; i++)
+    {
+      std::size_t acc = 0;
+      const bench_clock::time_point start = bench_clock::now();
+      for (const char* k : shuffled)
+        {
+          acc += table.lookup_index(k);
+        }
+      const double ns =
+          std::chrono::duration<double, std::nano>(bench_clock::now() - start)
+              .count() /
+          shuffled.size();
+      p.ns_per_lookup = (i == 0) ? ns : std::min(p.ns_per_lookup, ns);
+      sink = acc;
+    }
+  std::size_t lines = 0;
+  for (const char* k : shuffled)
+    {
+      lines += table.lines(k, std::strlen(k) + 1);
+    }
+  p.lines_per_lookup = double(lines) / shuffled.size();
+  return p;
+}
+
+// Metric names, service.host.metric.stat
+std::vector<std::string> metrics(std::size_t n)
+{
+  const char* services[] = {"api", "auth", "billing", "db", "search",
+                            "static", "queue"};
+  const char* names[] = {"requests", "errors", "latency", "bytes_in",
+                         "bytes_out", "connections", "retries", "queue_depth"};
+  std::vector<std::string> keys;
+  keys.reserve(n);
+  for (std::size_t i = 0; i < n; i++)
+    {
+      keys.push_back(std::string(services[i % 7]) + ".host" +
+                     std::to_string(i / 7 % 1000) + "." + names[i / 7000 % 8] +
+                     ".p" + std::to_string(i / 56000) + "_" +
+                     std::to_string(i % 97));
+    }
+  return keys;
+}
+
+// Builds T(keys, args...)
+template <typename T, typename... Args>
+result measure(const char* name, unsigned threads,
+               const std::vector<std::string>& keys, const options& opt,
+               Args... args)
+{
+  result r = {name, threads, 0, 0, 0, 0};
+  for (unsigned i = 0; i < opt.repetitions; i++)
+    {
+      const std::size_t before = live;
+      peak = before;
+      const bench_clock::time_point start = bench_clock::now();
+      const T table(keys, args...);
+      const double seconds =
+          std::chrono::duration<double>(bench_clock::now() - start).count();
+      r.seconds = (i == 0) ? seconds : std::min(r.seconds, seconds);
+      r.peak = peak - before;
+      r.retained = live - before;
+      r.rows = table.size();
+    }
+  return r;
+}
+
+bool parse(int argc, char** argv, options& opt)
+{
+  for (int i = 1; i < argc; i++)
+    {
+      const bool more = i + 1 < argc;
+      if (!std::strcmp(argv[i], "--json"))
+        {
+          opt.json = true;
+        }
+      else if (more && !std::strcmp(argv[i], "--keys"))
+        {
+          opt.keys = std::max(1ul, std::strtoul(argv[++i], nullptr, 10));
+        }
+      else if (more && !std::strcmp(argv[i], "--threads"))
+        {
+          opt.threads = std::max(1, std::atoi(argv[++i]));
+        }
+      else if (more && !std::strcmp(argv[i], "--repetitions"))
+        {
+          opt.repetitions = std::max(1, std::atoi(argv[++i]));
+        }
+      else
+        {
+          std::fprintf(stderr,
+                       "Usage: %s [--keys N] [--threads N] [--repetitions N] "
+                       "[--json]\n",
+                       argv[0]);
+          return false;
+        }
+    }
+  return true;
+}
+}
+
+int main(int argc, char** argv)
+{
+  options opt;
+  if (!parse(argc, argv, opt))
+    {
+      return 1;
+    }
+
+  const std::vector<std::string> keys = metrics(opt.keys);
+  std::vector<result> results;
+  results.push_back(measure<prefix::runtime_table>("runtime", 1, keys, opt));
+  results.push_back(measure<prefix::art_table>("art", 1, keys, opt, 1u));
+  if (opt.threads > 1)
+    {
+      results.push_back(measure<prefix::art_table>("art", opt.threads, keys,
+                                                   opt, opt.threads));
+    }
+  const probe probes[] = {
+      measure_lookups("breadth_first", prefix::art_table::breadth_first,
+                      keys, opt),
+      measure_lookups("blocked", prefix::art_table::blocked, keys, opt),
+  };
+
+  if (opt.json)
+    {
+      std::printf("{\n  \"keys\": %zu,\n  \"results\": [\n", opt.keys);
+      for (std::size_t i = 0; i < results.size(); i++)
+        {
+          const result& r = results[i];
+          std::printf("    {\"table\": \"%s\", \"threads\": %u, "
+                      "\"rows\": %zu, "
+                      "\"seconds\": %.4f, \"peak_bytes\": %zu, "
+                      "\"retained_bytes\": %zu}%s\n",
+                      r.name, r.threads, r.rows, r.seconds, r.peak, r.retained,
+                      (i + 1 < results.size()) ? "," : "");
+        }
+      std::printf("  ],\n  \"lookups\": [\n");
+      for (const probe& p : probes)
+        {
+          std::printf("    {\"layout\": \"%s\", \"bytes\": %zu, "
+                      "\"ns_per_lookup\": %.2f, \"lines_per_lookup\": %.2f}"
+                      "%s\n",
+                      p.layout, p.bytes, p.ns_per_lookup, p.lines_per_lookup,
+                      (&p == &probes[1]) ? "" : ",");
+        }
+      std::printf("  ]\n}\n");
+      return 0;
+    }
+  std::printf("%-8s %8s %10s %10s %12s %12s\n", "table", "threads", "rows",
+              "seconds", "peak MB", "retained MB");
+  for (const result& r : results)
+    {
+      std::printf("%-8s %8u %10zu %10.3f %12.1f %12.1f\n", r.name, r.threads,
+                  r.rows, r.seconds, r.peak / 1e6, r.retained / 1e6);
+    }
+  std::printf("\n%-14s %10s %10s %10s\n", "art layout", "MB", "ns/lookup",
+              "lines");
+  for (const probe& p : probes)
+    {
+      std::printf("%-14s %10.1f %10.1f %10.2f\n", p.layout, p.bytes / 1e6,
+                  p.ns_per_lookup, p.lines_per_lookup);
+    }
+  return 0;
+}
@@ -0,0 +1,82 @@
+# Usage: code_size.py OBJECT[:SOURCE]... [--json]
+# Sums the text size of each table's lookup code in the objects. Functions
+# of prefix::crtp<T, ...>, tiny<T> and interpreted<T> belong to table T, as
+# do the T_lookup_NAME wrappers bench.py generates. Row and node counts are read
+# from the "// table T: R rows, N nodes" lines bench.py writes to SOURCE
+import argparse
+import json
+import re
+import subprocess
+
+parser = argparse.ArgumentParser(
+    description="Report code size per table and lookup function")
+parser.add_argument("objects", nargs="+", help="OBJECT or OBJECT:SOURCE")
+parser.add_argument("--json", action="store_true", help="print JSON")
+args = parser.parse_args()
+
+member = re.compile(
+    r"prefix::(?:crtp|tiny|interpreted)<\(?([A-Za-z_][\w:]*)")
+wrapper = re.compile(r"^([A-Za-z_]\w*?)_lookup_(\w+)\(")
+counts = re.compile(r"^// table (\w+): (\d+) rows, (\d+) nodes")
+
+
+def text_symbols(obj):
+    out = subprocess.check_output(
+        ["nm", "-C", "-S", "--defined-only", obj]).decode()
+    for line in out.splitlines():
+        fields = line.split(None, 3)
+        if len(fields) == 4 and fields[2] in "tTwW":
+            yield int(fields[1], 16), fields[3]
+
+
+results = []
+for arg in args.objects:
+    obj, _, source = arg.partition(":")
+    tables = {}
+    if source:
+        with open(source) as f:
+            for line in f:
+                m = counts.match(line)
+                if m:
+                    tables[m.group(1)] = (int(m.group(2)), int(m.group(3)))
+
+    # (table, function) -> bytes. Out of line crtp members are shared
+    # between the lookup functions, so are reported on their own
+    sizes = {}
+    for size, name in text_symbols(obj):
+        m = wrapper.match(name)
+        if m:
+            key = (m.group(1), m.group(2))
+        else:
+            m = member.search(name)
+            if not m:
+                continue
+            key = (m.group(1).split("::")[-1], "members")
+        sizes[key] = sizes.get(key, 0) + size
+
+    for (table, function), size in sorted(sizes.items()):
+        rows, nodes = tables.get(table, (None, None))
+        results.append({
+            "object": obj,
+            "table": table,
+            "function": function,
+            "text_bytes": size,
+            "rows": rows,
+            "nodes": nodes,
+            "bytes_per_key": round(size / rows, 1) if rows else None,
+            "bytes_per_node": round(size / nodes, 1) if nodes else None,
+        })
+
+if args.json:
+    print(json.dumps(results, indent=2))
+else:
+    def cell(x):
+        return "-" if x is None else str(x)
+    print("{0:<14} {1:<10} {2:<10} {3:>8} {4:>7} {5:>7} {6:>9} {7:>10}".format(
+        "object", "table", "function", "bytes", "rows", "nodes", "bytes/key",
+        "bytes/node"))
+    for r in results:
+        print("{0:<14} {1:<10} {2:<10} {3:>8} {4:>7} {5:>7} {6:>9} {7:>10}"
+              .format(r["object"], r["table"], r["function"], r["text_bytes"],
+                      cell(r["rows"]), cell(r["nodes"]),
+                      cell(r["bytes_per_key"]), cell(r["bytes_per_node"])))
@@ -0,0 +1,35 @@
+# Usage: compare.py SIZE... [-- bench_main options]
+# Runs cmp_SIZE.exe for each size, as built by make compare, and prints
+# ns/lookup for every variant with one column per table size
+import json
+import subprocess
+import sys
+
+argv = sys.argv[1:]
+extra = []
+if '--' in argv:
+    extra = argv[argv.index('--') + 1:]
+    argv = argv[:argv.index('--')]
+sizes = argv
+
+results = {}
+variants = []
+workloads = []
+for size in sizes:
+    out = subprocess.check_output(['./cmp_{0}.exe'.format(size), '--json'] + extra)
+    for r in json.loads(out.decode())['results']:
+        if r['variant'] not in variants:
+            variants.append(r['variant'])
+        if r['workload'] not in workloads:
+            workloads.append(r['workload'])
+        results[(r['workload'], r['variant'], size)] = r['ns_per_lookup']
+
+for w in workloads:
+    print('{0:<12} {1}'.format(w + ' ns', ' '.join('{0:>9}'.format(s) for s in sizes)))
+    for v in variants:
+        cells = []
+        for s in sizes:
+            t = results.get((w, v, s))
+            cells.append('{0:>9}'.format('-' if t is None else '{0:.2f}'.format(t)))
+        print('{0:<12} {1}'.format(v, ' '.join(cells)))
+    print('')
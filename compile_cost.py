@@ -0,0 +1,104 @@
+# Usage: compile_cost.py [--cxx CXX] [--flags FLAGS] [--sizes N...]
+#                        [--lengths N...] [--json]
+# Generates a table with bench.py for each size and key length, compiles
+# the prefix variant alone and reports the cost of doing so
+import argparse
+import json
+import os
+import shlex
+import subprocess
+import sys
+import tempfile
+import time
+
+parser = argparse.ArgumentParser(
+    description="Measure the cost of compiling crtp tables")
+parser.add_argument("--cxx", default="clang++ -std=c++11",
+                    help="compiler and any leading options")
+parser.add_argument("--flags", default="-O2", help="compiler options")
+parser.add_argument("--sizes", type=int, nargs="+", default=[10, 25, 50, 100],
+                    help="rows per table")
+parser.add_argument("--lengths", type=int, nargs="+", default=[8, 32],
+                    help="length of the random keys")
+parser.add_argument("--json", action="store_true", help="print JSON")
+args = parser.parse_args()
+
+here = os.path.dirname(os.path.abspath(__file__))
+
+
+def compile_once(src, obj, trace):
+    # Wall time and the peak RSS of this one compiler process, in KiB
+    cmd = shlex.split(args.cxx) + shlex.split(args.flags) + [
+        "-DPRE=1", "-DNDEBUG", "-I", here, "-c", src, "-o", obj]
+    if trace:
+        cmd.append("-ftime-trace")
+    start = time.time()
+    proc = subprocess.Popen(cmd, stderr=subprocess.DEVNULL)
+    _, status, usage = os.wait4(proc.pid, 0)
+    seconds = time.time() - start
+    if not os.WIFEXITED(status) or os.WEXITSTATUS(status) != 0:
+        sys.exit("Failed: " + " ".join(cmd))
+    return seconds, usage.ru_maxrss
+
+
+def instantiations(obj):
+    # Counted from clang's -ftime-trace output, written next to the object
+    trace = os.path.splitext(obj)[0] + ".json"
+    if not os.path.exists(trace):
+        return None
+    with open(trace) as f:
+        events = json.load(f)["traceEvents"]
+    return sum(1 for e in events
+               if e.get("ph") == "X" and e.get("name") in
+               ("InstantiateFunction", "InstantiateClass"))
+
+
+def text_size(obj):
+    try:
+        out = subprocess.check_output(["size", obj]).decode()
+        return int(out.splitlines()[1].split()[0])
+    except (OSError, subprocess.CalledProcessError, IndexError, ValueError):
+        return None
+
+
+clang = "clang" in args.cxx
+results = []
+with tempfile.TemporaryDirectory() as tmp:
+    for length in args.lengths:
+        for size in args.sizes:
+            src = os.path.join(tmp, "cost_{0}_{1}.cpp".format(size, length))
+            obj = os.path.splitext(src)[0] + ".o"
+            with open(src, "w") as f:
+                subprocess.check_call(
+                    [sys.executable, os.path.join(here, "bench.py"),
+                     "--size", str(size), "--minsize", str(length),
+                     "--maxsize", str(length)], stdout=f)
+            seconds, rss = compile_once(src, obj, clang)
+            results.append({
+                "size": size,
+                "length": length,
+                "seconds": round(seconds, 3),
+                "peak_rss_kib": rss,
+                "instantiations": instantiations(obj),
+                "object_bytes": os.path.getsize(obj),
+                "text_bytes": text_size(obj),
+            })
+            if not args.json:
+                r = results[-1]
+                if len(results) == 1:
+                    print("{0:>6} {1:>6} {2:>9} {3:>12} {4:>14} {5:>10} {6:>10}"
+                          .format("rows", "length", "seconds", "peak RSS KiB",
+                                  "instantiations", "object", "text"))
+                print("{0:>6} {1:>6} {2:>9.2f} {3:>12} {4:>14} {5:>10} {6:>10}"
+                      .format(r["size"], r["length"], r["seconds"],
+                              r["peak_rss_kib"],
+                              "-" if r["instantiations"] is None
+                              else r["instantiations"],
+                              r["object_bytes"],
+                              "-" if r["text_bytes"] is None
+                              else r["text_bytes"]))
+                sys.stdout.flush()
+
+if args.json:
+    print(json.dumps({"cxx": args.cxx, "flags": args.flags,
+                      "results": results}, indent=2))
@@ -0,0 +1,153 @@
+/*
+ * This file is part of PrefixTree
+ *
+ * The MIT License (MIT)
+ * 
+ * Copyright (c) 2016 Jon Chesterfield
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "dynamic.hpp"
+#include "prefix.hpp"
+#include "catch.hpp"
+
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+struct headers : prefix::crtp<headers>
+{
+  static constexpr element table[] = {
+      "",        "content-encoding", "content-language", "content-length",
+      "content-type", "context",     "cookie",           "\xff",
+  };
+};
+
+// Index of the row found, or fail()
+std::size_t find(const prefix::dynamic_table<std::size_t>& t, const char* key)
+{
+  std::size_t index = headers::fail();
+  t.lookup(key, index);
+  return index;
+}
+}
+constexpr decltype(headers::table) headers::table;
+
+TEST_CASE("dynamic table matches crtp")
+{
+  const char* keys[] = {"content-type: text", "content-length",
+                        "content-lengthy",    "content-lengt",
+                        "context",            "contex",
+                        "cookies",            "coo",
+                        "",                   "\xff\xff",
+                        "\xfe"};
+  prefix::dynamic_table<std::size_t> t;
+  // Inserted out of order
+  for (std::size_t i = headers::size(); i-- > 0;)
+    {
+      CHECK(t.insert(std::string(headers::get(i).data(),
+                                 headers::get(i).size()),
+                     i));
+    }
+  CHECK(headers::size() == t.size());
+  CHECK(!t.insert("cookie", 6));
+  CHECK(headers::size() == t.size());
+  for (const char* k : keys)
+    {
+      CHECK(headers::lookup_index_critbit(k) == find(t, k));
+    }
+
+  prefix::dynamic_table<std::size_t>::reader r(t);
+  std::size_t index = 0;
+  CHECK(r.lookup("content-lengthy", 14, index));
+  CHECK(3 == index);
+}
+
+TEST_CASE("dynamic table erase")
+{
+  prefix::dynamic_table<int> t;
+  CHECK(t.insert("content", 1));
+  CHECK(t.insert("content-length", 2));
+  CHECK(t.insert("content-type", 3));
+  int v = 0;
+  CHECK(t.lookup("content-lengthy", v));
+  CHECK(2 == v);
+
+  CHECK(t.erase("content-length"));
+  CHECK(!t.erase("content-length"));
+  CHECK(!t.erase("content-"));
+  CHECK(2 == t.size());
+  CHECK(t.lookup("content-lengthy", v));
+  CHECK(1 == v);
+
+  CHECK(t.erase("content"));
+  CHECK(!t.lookup("content-lengthy", v));
+  CHECK(t.lookup("content-type", v));
+  CHECK(3 == v);
+  CHECK(t.erase("content-type"));
+  CHECK(0 == t.size());
+  CHECK(!t.lookup("content-type", v));
+
+  // Erased paths are rebuilt
+  CHECK(t.insert("content-type", 4));
+  CHECK(t.lookup("content-type", v));
+  CHECK(4 == v);
+}
+
+TEST_CASE("dynamic table under concurrent readers")
+{
+  prefix::dynamic_table<int> t;
+  t.insert("/api", 0);
+  std::atomic<bool> done(false);
+  std::atomic<unsigned> bad(0);
+  std::vector<std::thread> readers;
+  for (int n = 0; n < 3; n++)
+    {
+      readers.emplace_back([&] {
+        prefix::dynamic_table<int>::reader r(t);
+        while (!done)
+          {
+            // /api is never erased, so /api/... always finds a value
+            int v = -1;
+            if (!r.lookup("/api/v1/users/42", v) || v < 0)
+              {
+                bad++;
+              }
+          }
+      });
+    }
+  for (int i = 0; i < 2000; i++)
+    {
+      const std::string key = "/api/v1/users/" + std::to_string(i % 50);
+      t.insert(key, i);
+      if (i % 3 == 0)
+        {
+          t.erase(key);
+        }
+    }
+  done = true;
+  for (std::thread& r : readers)
+    {
+      r.join();
+    }
+  CHECK(0u == bad);
+}
@@ -0,0 +1,317 @@
+/*
+ * This file is part of PrefixTree
+ *
+ * The MIT License (MIT)
+ * 
+ * Copyright (c) 2016 Jon Chesterfield
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifndef DYNAMIC_HPP
+#define DYNAMIC_HPP
+
+#include "rcu.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace prefix
+{
+// A trie of keys to values V that changes while it is read. insert and
+// erase take time in the length of the key, plus copying the children of
+// one node. Lookups match as crtp::lookup_index_critbit, the longest key
+// prefixing the one looked up.
+//
+// Children of a node are held in an immutable array. A writer copies it,
+// changes the copy and publishes it with one store, so readers only follow
+// pointers and never wait. Replaced arrays, nodes and values are freed
+// through an epoch_domain. Writers are serialised by a mutex
+template <typename V>
+class dynamic_table
+{
+ public:
+  // Up to slots readers at once
+  explicit dynamic_table(std::size_t slots = 64) : domain(slots), count(0) {}
+
+  dynamic_table(const dynamic_table&) = delete;
+  dynamic_table& operator=(const dynamic_table&) = delete;
+
+  // No reader may remain
+  ~dynamic_table() { destroy_children(&root); }
+
+  std::size_t size() const { return count.load(std::memory_order_relaxed); }
+
+  // Adds key, or replaces its value. Returns whether key is new
+  bool insert(const char* key, std::size_t length, const V& value)
+  {
+    std::lock_guard<std::mutex> lock(writer);
+    node* n = &root;
+    for (std::size_t i = 0; i < length; i++)
+      {
+        node* next = child(n, static_cast<unsigned char>(key[i]));
+        if (!next)
+          {
+            add_child(n, static_cast<unsigned char>(key[i]),
+                      chain(key + i + 1, length - i - 1, value));
+            count++;
+            domain.reclaim();
+            return true;
+          }
+        n = next;
+      }
+    const V* old = n->value.exchange(new V(value), std::memory_order_acq_rel);
+    if (old)
+      {
+        domain.retire(old);
+      }
+    else
+      {
+        count++;
+      }
+    domain.reclaim();
+    return !old;
+  }
+
+  bool insert(const std::string& key, const V& value)
+  {
+    return insert(key.data(), key.size(), value);
+  }
+
+  // Removes key. Returns whether it was present
+  bool erase(const char* key, std::size_t length)
+  {
+    std::lock_guard<std::mutex> lock(writer);
+    std::vector<node*> path(1, &root);
+    for (std::size_t i = 0; i < length && path.back(); i++)
+      {
+        path.push_back(child(path.back(), static_cast<unsigned char>(key[i])));
+      }
+    const V* old = path.back() ? path.back()->value.exchange(
+                                     nullptr, std::memory_order_acq_rel)
+                               : nullptr;
+    if (!old)
+      {
+        return false;
+      }
+    domain.retire(old);
+    count--;
+
+    // Unlink the nodes left with neither value nor children
+    for (std::size_t d = length; d > 0; d--)
+      {
+        node* n = path[d];
+        if (n->value.load(std::memory_order_relaxed) ||
+            n->out.load(std::memory_order_relaxed))
+          {
+            break;
+          }
+        remove_child(path[d - 1], static_cast<unsigned char>(key[d - 1]));
+        domain.retire(n);
+      }
+    domain.reclaim();
+    return true;
+  }
+
+  bool erase(const std::string& key) { return erase(key.data(), key.size()); }
+
+  // Reads from one thread, holding an epoch slot for as long as it lives.
+  // Each lookup is then wait free
+  class reader
+  {
+   public:
+    explicit reader(const dynamic_table& t) : table(t), slot(t.domain) {}
+
+    bool lookup(const char* key, V& out)
+    {
+      return lookup(key, std::strlen(key) + 1, out);
+    }
+
+    bool lookup(const char* key, std::size_t length, V& out)
+    {
+      slot.enter();
+      const bool found = table.walk(key, length, out);
+      slot.leave();
+      return found;
+    }
+
+   private:
+    const dynamic_table& table;
+    epoch_domain::participant slot;
+  };
+
+  // As reader::lookup, claiming a slot for this lookup alone
+  bool lookup(const char* key, V& out) const
+  {
+    return lookup(key, std::strlen(key) + 1, out);
+  }
+
+  bool lookup(const char* key, std::size_t length, V& out) const
+  {
+    const epoch_domain::guard claim(domain);
+    return walk(key, length, out);
+  }
+
+ private:
+  struct node;
+
+  // Children of a node, sorted by edge character
+  struct edges
+  {
+    std::vector<unsigned char> chars;
+    std::vector<node*> nodes;
+  };
+
+  struct node
+  {
+    node() : value(nullptr), out(nullptr) {}
+    std::atomic<const V*> value;
+    std::atomic<const edges*> out;
+  };
+
+  // Longest key prefixing the first length characters, copied to out
+  bool walk(const char* key, std::size_t length, V& out) const
+  {
+    const node* n = &root;
+    const V* found = n->value.load(std::memory_order_acquire);
+    for (std::size_t i = 0; i < length; i++)
+      {
+        const edges* e = n->out.load(std::memory_order_acquire);
+        if (!e)
+          {
+            break;
+          }
+        const unsigned char c = static_cast<unsigned char>(key[i]);
+        const std::size_t at =
+            std::lower_bound(e->chars.begin(), e->chars.end(), c) -
+            e->chars.begin();
+        if (at == e->chars.size() || e->chars[at] != c)
+          {
+            break;
+          }
+        n = e->nodes[at];
+        if (const V* v = n->value.load(std::memory_order_acquire))
+          {
+            found = v;
+          }
+      }
+    if (found)
+      {
+        out = *found;
+      }
+    return found != nullptr;
+  }
+
+  // The writer's view, which no other thread changes
+  static node* child(const node* n, unsigned char c)
+  {
+    const edges* e = n->out.load(std::memory_order_relaxed);
+    if (!e)
+      {
+        return nullptr;
+      }
+    const std::size_t at =
+        std::lower_bound(e->chars.begin(), e->chars.end(), c) -
+        e->chars.begin();
+    return (at < e->chars.size() && e->chars[at] == c) ? e->nodes[at]
+                                                       : nullptr;
+  }
+
+  // Nodes for the rest of a key, built before any reader can see them
+  static node* chain(const char* rest, std::size_t length, const V& value)
+  {
+    node* n = new node;
+    n->value.store(new V(value), std::memory_order_relaxed);
+    for (std::size_t i = length; i > 0; i--)
+      {
+        node* parent = new node;
+        edges* e = new edges;
+        e->chars.push_back(static_cast<unsigned char>(rest[i - 1]));
+        e->nodes.push_back(n);
+        parent->out.store(e, std::memory_order_relaxed);
+        n = parent;
+      }
+    return n;
+  }
+
+  void add_child(node* n, unsigned char c, node* added)
+  {
+    const edges* old = n->out.load(std::memory_order_relaxed);
+    edges* e = old ? new edges(*old) : new edges;
+    const std::size_t at =
+        std::lower_bound(e->chars.begin(), e->chars.end(), c) -
+        e->chars.begin();
+    e->chars.insert(e->chars.begin() + at, c);
+    e->nodes.insert(e->nodes.begin() + at, added);
+    n->out.store(e, std::memory_order_release);
+    if (old)
+      {
+        domain.retire(old);
+      }
+  }
+
+  void remove_child(node* n, unsigned char c)
+  {
+    const edges* old = n->out.load(std::memory_order_relaxed);
+    edges* e = nullptr;
+    if (old->chars.size() > 1)
+      {
+        e = new edges(*old);
+        const std::size_t at =
+            std::lower_bound(e->chars.begin(), e->chars.end(), c) -
+            e->chars.begin();
+        e->chars.erase(e->chars.begin() + at);
+        e->nodes.erase(e->nodes.begin() + at);
+      }
+    n->out.store(e, std::memory_order_release);
+    domain.retire(old);
+  }
+
+  static void destroy_children(node* n)
+  {
+    std::vector<node*> pending(1, n);
+    while (!pending.empty())
+      {
+        node* x = pending.back();
+        pending.pop_back();
+        delete x->value.load();
+        if (const edges* e = x->out.load())
+          {
+            pending.insert(pending.end(), e->nodes.begin(), e->nodes.end());
+            delete e;
+          }
+        if (x != n)
+          {
+            delete x;
+          }
+      }
+  }
+
+  node root;
+  epoch_domain domain;
+  std::mutex writer;
+  std::atomic<std::size_t> count;
+};
+}
+
+#endif  // DYNAMIC_HPP
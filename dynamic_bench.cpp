@@ -0,0 +1,224 @@
+// Read throughput of dynamic_table while a writer inserts and erases keys
+// at a sustained rate. Readers look up keys present throughout, the writer
+// churns a separate set of keys sharing their prefixes
+//   dynamic_bench.exe [--readers N] [--keys N] [--seconds S] [--json]
+#include "dynamic.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+typedef std::chrono::steady_clock bench_clock;
+
+struct options
+{
+  unsigned readers = std::max(1u, std::thread::hardware_concurrency());
+  std::size_t keys = 100000;
+  double seconds = 0.5;
+  bool json = false;
+};
+
+struct result
+{
+  double target;  // Writes per second asked for, 0 for as fast as possible
+                  // and negative for none
+  double writes_per_second;
+  double reads_per_second;  // All readers together
+};
+
+// Route like keys, /service/version/resource/id
+std::vector<std::string> routes(std::size_t n, std::size_t salt)
+{
+  const char* services[] = {"api", "auth", "billing", "search", "static"};
+  std::vector<std::string> keys;
+  for (std::size_t i = 0; i < n; i++)
+    {
+      keys.push_back("/" + std::string(services[i % 5]) + "/v" +
+                     std::to_string(i % 3) + "/r" + std::to_string(i / 15) +
+                     "/" + std::to_string(salt + i));
+    }
+  return keys;
+}
+
+// Writes each key of churn in, then out, paced to target per second. No
+// writes for a negative target
+result measure(prefix::dynamic_table<uint64_t>& table,
+               const std::vector<std::string>& hot,
+               const std::vector<std::string>& churn, double target,
+               const options& opt)
+{
+  std::atomic<bool> done(false);
+  std::vector<uint64_t> reads(opt.readers);
+  std::vector<std::thread> pool;
+  for (unsigned t = 0; t < opt.readers; t++)
+    {
+      pool.emplace_back([&, t] {
+        prefix::dynamic_table<uint64_t>::reader r(table);
+        uint64_t n = 0, sink = 0;
+        for (std::size_t i = t; !done; i = (i + 7919) % hot.size())
+          {
+            uint64_t v;
+            if (r.lookup(hot[i].c_str(), v))
+              {
+                sink += v;
+              }
+            n++;
+          }
+        reads[t] = n + (sink == 1);
+      });
+    }
+
+  const bench_clock::time_point start = bench_clock::now();
+  const bench_clock::time_point stop =
+      start + std::chrono::duration_cast<bench_clock::duration>(
+                  std::chrono::duration<double>(opt.seconds));
+  uint64_t writes = 0;
+  for (bench_clock::time_point now = start; now < stop;
+       now = bench_clock::now())
+    {
+      if (target < 0)
+        {
+          std::this_thread::sleep_until(stop);
+          continue;
+        }
+      if (target > 0)
+        {
+          const bench_clock::time_point due =
+              start + std::chrono::duration_cast<bench_clock::duration>(
+                          std::chrono::duration<double>(writes / target));
+          if (due > now)
+            {
+              std::this_thread::sleep_until(std::min(due, stop));
+              continue;
+            }
+        }
+      const std::string& key = churn[(writes / 2) % churn.size()];
+      if (writes % 2 == 0)
+        {
+          table.insert(key, writes);
+        }
+      else
+        {
+          table.erase(key);
+        }
+      writes++;
+    }
+  done = true;
+  for (std::thread& t : pool)
+    {
+      t.join();
+    }
+  const double elapsed =
+      std::chrono::duration<double>(bench_clock::now() - start).count();
+  uint64_t total = 0;
+  for (uint64_t r : reads)
+    {
+      total += r;
+    }
+  result r = {target, writes / elapsed, total / elapsed};
+  return r;
+}
+
+bool parse(int argc, char** argv, options& opt)
+{
+  for (int i = 1; i < argc; i++)
+    {
+      const bool more = i + 1 < argc;
+      if (!std::strcmp(argv[i], "--json"))
+        {
+          opt.json = true;
+        }
+      else if (more && !std::strcmp(argv[i], "--readers"))
+        {
+          opt.readers = std::max(1, std::atoi(argv[++i]));
+        }
+      else if (more && !std::strcmp(argv[i], "--keys"))
+        {
+          opt.keys = std::max(1ul, std::strtoul(argv[++i], nullptr, 10));
+        }
+      else if (more && !std::strcmp(argv[i], "--seconds"))
+        {
+          opt.seconds = std::atof(argv[++i]);
+        }
+      else
+        {
+          std::fprintf(stderr,
+                       "Usage: %s [--readers N] [--keys N] [--seconds S] "
+                       "[--json]\n",
+                       argv[0]);
+          return false;
+        }
+    }
+  return true;
+}
+}
+
+int main(int argc, char** argv)
+{
+  options opt;
+  if (!parse(argc, argv, opt))
+    {
+      return 1;
+    }
+
+  const std::vector<std::string> hot = routes(opt.keys, 0);
+  const std::vector<std::string> churn = routes(opt.keys, opt.keys);
+  prefix::dynamic_table<uint64_t> table(opt.readers + 8);
+  for (std::size_t i = 0; i < hot.size(); i++)
+    {
+      table.insert(hot[i], i);
+    }
+
+  const double targets[] = {-1, 1e3, 1e4, 1e5, 0};
+  std::vector<result> results;
+  for (double target : targets)
+    {
+      results.push_back(measure(table, hot, churn, target, opt));
+    }
+
+  if (opt.json)
+    {
+      std::printf("{\n  \"readers\": %u,\n  \"keys\": %zu,\n  \"results\": [\n",
+                  opt.readers, opt.keys);
+      for (std::size_t i = 0; i < results.size(); i++)
+        {
+          const result& r = results[i];
+          std::printf("    {\"target_writes_per_second\": %.0f, "
+                      "\"writes_per_second\": %.0f, "
+                      "\"reads_per_second\": %.0f}%s\n",
+                      r.target, r.writes_per_second, r.reads_per_second,
+                      (i + 1 < results.size()) ? "," : "");
+        }
+      std::printf("  ]\n}\n");
+      return 0;
+    }
+  std::printf("%14s %14s %14s\n", "target w/s", "writes/s", "reads/s");
+  for (const result& r : results)
+    {
+      if (r.target < 0)
+        {
+          std::printf("%14s", "none");
+        }
+      else if (r.target == 0)
+        {
+          std::printf("%14s", "max");
+        }
+      else
+        {
+          std::printf("%14.0f", r.target);
+        }
+      std::printf(" %14.0f %14.0f\n", r.writes_per_second,
+                  r.reads_per_second);
+    }
+  return 0;
+}
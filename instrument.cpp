@@ -0,0 +1,126 @@
+/*
+ * This file is part of PrefixTree
+ *
+ * The MIT License (MIT)
+ * 
+ * Copyright (c) 2016 Jon Chesterfield
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "instrument.hpp"
+#include "simd.hpp"
+#include "catch.hpp"
+
+#include <cstdio>
+
+namespace
+{
+struct counted : prefix::crtp<counted, int, prefix::instrumented>
+{
+  static constexpr element table[] = {
+      {"bar", 0}, {"barz", 1}, {"foo", 2}, {"wombat", 3},
+  };
+};
+
+struct plain : prefix::crtp<plain, int>
+{
+  static constexpr element table[] = {
+      {"bar", 0}, {"barz", 1}, {"foo", 2}, {"wombat", 3},
+  };
+};
+}
+constexpr decltype(counted::table) counted::table;
+constexpr decltype(plain::table) plain::table;
+
+// Uninstrumented lookups are still constant expressions
+static_assert(2 == plain::lookup_index_critbit("foo", 3), "");
+
+TEST_CASE("instrumented lookups agree with uninstrumented")
+{
+  const char* keys[] = {"bar", "barz", "barzoo", "ba", "foo", "fob", "", "x"};
+  for (const char* k : keys)
+    {
+      CHECK(plain::lookup_index(k) == counted::lookup_index(k));
+      CHECK(plain::lookup_index_critbit(k) == counted::lookup_index_critbit(k));
+      CHECK(plain::lookup_index_stride(k) == counted::lookup_index_stride(k));
+      CHECK(prefix::tiny<plain>::lookup_index(k) ==
+            prefix::tiny<counted>::lookup_index(k));
+    }
+}
+
+TEST_CASE("instrumented counts hits and miss depths")
+{
+  typedef prefix::instrumented policy;
+  policy::reset<counted>();
+
+  CHECK(1 == counted::lookup_index("barz"));
+  CHECK(1 == counted::lookup_index_critbit("barzoo"));
+  CHECK(0 == counted::lookup_index_critbit("bark"));
+  CHECK(3 == counted::lookup_index("wombats"));
+  CHECK(4 == counted::lookup_index("fox"));
+  CHECK(4 == counted::lookup_index("wombe"));
+  CHECK(4 == counted::lookup_index("x"));
+  CHECK(4 == counted::lookup_index("ba"));
+
+  CHECK(8 == policy::lookups<counted>());
+  CHECK(1 == policy::hits<counted>(0));
+  CHECK(2 == policy::hits<counted>(1));
+  CHECK(0 == policy::hits<counted>(2));
+  CHECK(1 == policy::hits<counted>(3));
+
+  // fox and ba fail after two characters, wombe after four, x at once
+  CHECK(1 == policy::misses<counted>(0));
+  CHECK(2 == policy::misses<counted>(2));
+  CHECK(1 == policy::misses<counted>(4));
+
+  // fox and wombe had narrowed to a single row
+  CHECK(2 == policy::tail_misses<counted>());
+
+  policy::reset<counted>();
+  CHECK(0 == policy::lookups<counted>());
+  CHECK(0 == policy::hits<counted>(1));
+}
+
+TEST_CASE("instrumented dump")
+{
+  typedef prefix::instrumented policy;
+  policy::reset<counted>();
+  counted::lookup_index("foo");
+  counted::lookup_index("fob");
+
+  char buffer[512] = {0};
+  std::FILE* f = std::tmpfile();
+  REQUIRE(f);
+  policy::dump<counted>("counted", f);
+  std::rewind(f);
+  const std::size_t n = std::fread(buffer, 1, sizeof(buffer) - 1, f);
+  std::fclose(f);
+  buffer[n] = '\0';
+
+  CHECK(std::strstr(buffer, "counted.lookups 2\n"));
+  CHECK(std::strstr(buffer, "counted.misses 1\n"));
+  CHECK(std::strstr(buffer, "counted.tail_misses 1\n"));
+  CHECK(std::strstr(buffer, "counted.row.2 1\n"));
+  CHECK(std::strstr(buffer, "counted.first_byte.0x66 2\n"));
+  CHECK(std::strstr(buffer, "counted.hit_depth.3 1\n"));
+  CHECK(std::strstr(buffer, "counted.miss_depth.2 1\n"));
+  CHECK(std::strstr(buffer, "counted.level.0 2\n"));
+  CHECK(std::strstr(buffer, "counted.level.2 2\n"));
+  CHECK(!std::strstr(buffer, "counted.level.3"));
+}
@@ -0,0 +1,312 @@
+/*
+ * This file is part of PrefixTree
+ *
+ * The MIT License (MIT)
+ * 
+ * Copyright (c) 2016 Jon Chesterfield
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifndef INSTRUMENT_HPP
+#define INSTRUMENT_HPP
+
+#include "prefix.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+namespace prefix
+{
+// Instrumentation policy counting where lookups go, per table
+// struct t : prefix::crtp<t, int, prefix::instrumented> records every lookup
+// of t, and prefix::instrumented::dump<t>("t", stdout) prints the counts.
+// Counters are relaxed atomics, safe to dump while other threads look up.
+// The default policy, prefix::uninstrumented, compiles to nothing
+class instrumented
+{
+ public:
+  template <typename T>
+  static std::size_t record(std::size_t index, const char* key)
+  {
+    return record<T>(index, key, std::strlen(key));
+  }
+
+  // The first length characters of key may be read
+  template <typename T>
+  static std::size_t record(std::size_t index, const char* key,
+                            std::size_t length)
+  {
+    counts& c = get<T>();
+    add(c.lookups);
+    if (length > 0)
+      {
+        add(c.first_byte[static_cast<unsigned char>(key[0])]);
+      }
+    if (index != T::fail())
+      {
+        add(c.rows[index]);
+        add(c.hit_depth[T::get(index).size()]);
+      }
+    else
+      {
+        bool tail;
+        add(c.miss_depth[miss_depth<T>(key, length, tail)]);
+        if (tail)
+          {
+            add(c.tail_misses);
+          }
+      }
+    return index;
+  }
+
+  // Print the non-zero counts as "name.counter value" lines:
+  //   lookups, misses, tail_misses - misses after narrowing to a single row
+  //   row.R - hits on row R
+  //   first_byte.0xXX - lookups starting with that character
+  //   hit_depth.D, miss_depth.D - characters matched by hits and misses
+  //   level.D - lookups that dispatched on character D
+  template <typename T>
+  static void dump(const char* name, std::FILE* out)
+  {
+    const counts& c = get<T>();
+    const std::size_t depths = c.hit_depth.size();
+    uint64_t misses = 0;
+    for (std::size_t d = 0; d < depths; d++)
+      {
+        misses += load(c.miss_depth[d]);
+      }
+    std::fprintf(out, "%s.lookups %llu\n", name, ull(load(c.lookups)));
+    std::fprintf(out, "%s.misses %llu\n", name, ull(misses));
+    std::fprintf(out, "%s.tail_misses %llu\n", name, ull(load(c.tail_misses)));
+    for (std::size_t r = 0; r < c.rows.size(); r++)
+      {
+        print(out, name, "row.", r, load(c.rows[r]));
+      }
+    for (unsigned b = 0; b < 256; b++)
+      {
+        if (load(c.first_byte[b]))
+          {
+            std::fprintf(out, "%s.first_byte.0x%02x %llu\n", name, b,
+                         ull(load(c.first_byte[b])));
+          }
+      }
+    for (std::size_t d = 0; d < depths; d++)
+      {
+        print(out, name, "hit_depth.", d, load(c.hit_depth[d]));
+      }
+    for (std::size_t d = 0; d < depths; d++)
+      {
+        print(out, name, "miss_depth.", d, load(c.miss_depth[d]));
+      }
+    // A hit of depth D dispatched on characters 0 to D - 1, a miss of depth
+    // D on characters 0 to D, the last of which failed
+    uint64_t level = 0;
+    std::vector<uint64_t> levels(depths);
+    for (std::size_t d = depths; d-- > 0;)
+      {
+        level += load(c.miss_depth[d]);
+        levels[d] = level;
+        level += load(c.hit_depth[d]);
+      }
+    for (std::size_t d = 0; d < depths; d++)
+      {
+        print(out, name, "level.", d, levels[d]);
+      }
+  }
+
+  template <typename T>
+  static void reset()
+  {
+    counts& c = get<T>();
+    c.lookups.store(0, std::memory_order_relaxed);
+    c.tail_misses.store(0, std::memory_order_relaxed);
+    for (std::atomic<uint64_t>& x : c.first_byte)
+      {
+        x.store(0, std::memory_order_relaxed);
+      }
+    for (std::vector<std::atomic<uint64_t>>* v :
+         {&c.rows, &c.hit_depth, &c.miss_depth})
+      {
+        for (std::atomic<uint64_t>& x : *v)
+          {
+            x.store(0, std::memory_order_relaxed);
+          }
+      }
+  }
+
+  template <typename T>
+  static uint64_t lookups()
+  {
+    return load(get<T>().lookups);
+  }
+
+  template <typename T>
+  static uint64_t hits(std::size_t row)
+  {
+    return load(get<T>().rows[row]);
+  }
+
+  template <typename T>
+  static uint64_t misses(std::size_t depth)
+  {
+    return load(get<T>().miss_depth[depth]);
+  }
+
+  template <typename T>
+  static uint64_t tail_misses()
+  {
+    return load(get<T>().tail_misses);
+  }
+
+ private:
+  struct counts
+  {
+    counts(std::size_t rows, std::size_t depths)
+        : lookups(0),
+          tail_misses(0),
+          rows(rows),
+          hit_depth(depths),
+          miss_depth(depths)
+    {
+      for (std::atomic<uint64_t>& x : first_byte)
+        {
+          x.store(0, std::memory_order_relaxed);
+        }
+    }
+
+    std::atomic<uint64_t> lookups;
+    std::atomic<uint64_t> tail_misses;
+    std::atomic<uint64_t> first_byte[256];
+    std::vector<std::atomic<uint64_t>> rows;
+    std::vector<std::atomic<uint64_t>> hit_depth;  // Indexed by row length
+    std::vector<std::atomic<uint64_t>> miss_depth; // By characters matched
+  };
+
+  template <typename T>
+  static counts& get()
+  {
+    static counts c(T::size(), T::template max_key_size<0, T::size()>() + 1);
+    return c;
+  }
+
+  static void add(std::atomic<uint64_t>& x)
+  {
+    x.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  static uint64_t load(const std::atomic<uint64_t>& x)
+  {
+    return x.load(std::memory_order_relaxed);
+  }
+
+  static unsigned long long ull(uint64_t x) { return x; }
+
+  static void print(std::FILE* out, const char* name, const char* counter,
+                    std::size_t i, uint64_t value)
+  {
+    if (value)
+      {
+        std::fprintf(out, "%s.%s%zu %llu\n", name, counter, i, ull(value));
+      }
+  }
+
+  // Characters the key shares with row R
+  template <typename T>
+  static std::size_t common(std::size_t R, const char* key,
+                            std::size_t length)
+  {
+    const str_const row = T::get(R);
+    std::size_t i = 0;
+    while (i < length && i < row.size() && row[i] == key[i])
+      {
+        i++;
+      }
+    return i;
+  }
+
+  // Is row R after the key, in the order of crtp::ordered
+  template <typename T>
+  static bool after(std::size_t R, const char* key, std::size_t length)
+  {
+    const str_const row = T::get(R);
+    const std::size_t i = common<T>(R, key, length);
+    if (i == row.size() || i == length)
+      {
+        return length < row.size();
+      }
+    return static_cast<unsigned char>(key[i]) <
+           static_cast<unsigned char>(row[i]);
+  }
+
+  // The depth at which a trie walk for the key fails is the longest prefix
+  // it shares with any row, found at its neighbours in the sorted table.
+  // Tail is set if only one row shares that prefix, so the walk had
+  // narrowed to one row before failing
+  template <typename T>
+  static std::size_t miss_depth(const char* key, std::size_t length,
+                                bool& tail)
+  {
+    std::size_t lower = 0;
+    std::size_t upper = T::size();
+    while (lower < upper)
+      {
+        const std::size_t mid = (lower + upper) / 2;
+        if (after<T>(mid, key, length))
+          {
+            upper = mid;
+          }
+        else
+          {
+            lower = mid + 1;
+          }
+      }
+
+    const std::size_t before =
+        (lower > 0) ? common<T>(lower - 1, key, length) : 0;
+    const std::size_t next =
+        (lower < T::size()) ? common<T>(lower, key, length) : 0;
+    const std::size_t depth = std::max(before, next);
+
+    // Rows sharing the prefix are contiguous, so one more either side of
+    // the neighbour that shares it tells whether there are several
+    const bool below = (lower > 0) && before == depth;
+    const bool above = (lower < T::size()) && next == depth;
+    if (below && above)
+      {
+        tail = false;
+      }
+    else if (below)
+      {
+        tail = !(lower > 1 && common<T>(lower - 2, key, length) >= depth);
+      }
+    else
+      {
+        tail = !(lower + 1 < T::size() &&
+                 common<T>(lower + 1, key, length) >= depth);
+      }
+    return depth;
+  }
+};
+}
+
+#endif  // INSTRUMENT_HPP
@@ -0,0 +1,143 @@
+/*
+ * This file is part of PrefixTree
+ *
+ * The MIT License (MIT)
+ * 
+ * Copyright (c) 2016 Jon Chesterfield
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "interpret.hpp"
+#include "catch.hpp"
+
+namespace
+{
+struct headers : prefix::crtp<headers>
+{
+  static constexpr element table[] = {
+      "content-encoding", "content-language", "content-length",
+      "content-type",     "context",          "cookie",
+  };
+};
+
+struct nested : prefix::crtp<nested, int>
+{
+  static constexpr element table[] = {
+      {"", 0}, {"a", 1}, {"ab", 2}, {"abc", 3}, {"b\x80", 4}, {"\xff", 5},
+  };
+};
+
+// As headers, running only the first two levels as code
+struct shallow : prefix::crtp<shallow>
+{
+  static constexpr element table[] = {
+      "content-encoding", "content-language", "content-length",
+      "content-type",     "context",          "cookie",
+  };
+  static constexpr std::size_t unrolled = 2;
+};
+}
+constexpr decltype(headers::table) headers::table;
+constexpr decltype(nested::table) nested::table;
+constexpr decltype(shallow::table) shallow::table;
+
+TEST_CASE("interpreted node layout")
+{
+  const prefix::interpreted_trie t = prefix::interpreted<nested>::trie();
+  const prefix::interpreted_node* n = t.nodes;
+  static_assert(7 == nested::node_count(), "");
+  // Root (""), a, ab, abc, b, b\x80, \xff, each with its children's slots
+  CHECK(0 == n[0].first);
+  CHECK(3 == n[0].count);
+  CHECK(0 == n[0].row);
+  CHECK('a' == t.edges[0]);
+  CHECK('b' == t.edges[1]);
+  CHECK(0xff == t.edges[2]);
+  CHECK(1 == t.children[0]);
+  CHECK(4 == t.children[1]);
+  CHECK(6 == t.children[2]);
+  CHECK(3 == n[1].first);
+  CHECK(1 == n[1].count);
+  CHECK(1 == n[1].row);
+  CHECK('b' == t.edges[3]);
+  CHECK(2 == t.children[3]);
+  CHECK(4 == n[2].first);
+  CHECK(3 == t.children[4]);
+  CHECK(0 == n[3].count);
+  CHECK(3 == n[3].row);
+  CHECK(5 == n[4].first);
+  CHECK(nested::fail() == n[4].row);
+  CHECK(0x80 == t.edges[5]);
+  CHECK(5 == t.children[5]);
+  CHECK(0 == n[5].count);
+  CHECK(6 == n[6].first);
+  CHECK(0 == n[6].count);
+}
+
+TEST_CASE("interpreted agrees with critbit")
+{
+  const char* keys[] = {"content-type: text", "content-length",
+                        "content-lengthy",    "content-lengt",
+                        "context",            "contex",
+                        "cookies",            "coo",
+                        "",                   "a",
+                        "abd",                "abcd",
+                        "b",                  "b\x80\x80",
+                        "\xff\xff",           "\xfe"};
+  for (const char* k : keys)
+    {
+      CHECK(headers::lookup_index_critbit(k) ==
+            prefix::interpreted<headers>::lookup_index(k));
+      CHECK(nested::lookup_index_critbit(k) ==
+            prefix::interpreted<nested>::lookup_index(k));
+    }
+  CHECK(3 == prefix::interpreted<headers>::lookup_index("content-type"));
+  CHECK(6 == prefix::interpreted<headers>::lookup_index("content-typ"));
+  CHECK(2 == prefix::interpreted<nested>::lookup_index("abc", 2));
+  CHECK(0 == prefix::interpreted<nested>::lookup_index("abc", 0));
+}
+
+TEST_CASE("hybrid agrees with critbit")
+{
+  static_assert(2 == prefix::interpreted<shallow>::unrolled(), "");
+  static_assert(16 == prefix::interpreted<headers>::unrolled(), "");
+  static_assert(3 == prefix::interpreted<nested>::unrolled(), "");
+  const char* keys[] = {"content-type: text", "content-length",
+                        "content-lengthy",    "content-lengt",
+                        "context",            "contex",
+                        "cookies",            "coo",
+                        "c",                  "",
+                        "a",                  "abd",
+                        "abcd",               "b",
+                        "b\x80\x80",          "\xff\xff",
+                        "\xfe"};
+  for (const char* k : keys)
+    {
+      CHECK(headers::lookup_index_critbit(k) ==
+            prefix::interpreted<headers>::lookup_index_hybrid(k));
+      CHECK(headers::lookup_index_critbit(k) ==
+            prefix::interpreted<shallow>::lookup_index_hybrid(k));
+      CHECK(nested::lookup_index_critbit(k) ==
+            prefix::interpreted<nested>::lookup_index_hybrid(k));
+    }
+  CHECK(2 == prefix::interpreted<nested>::lookup_index_hybrid("abc", 2));
+  CHECK(0 == prefix::interpreted<nested>::lookup_index_hybrid("abc", 0));
+  CHECK(2 == prefix::interpreted<shallow>::lookup_index_hybrid(
+                 "content-lengthy", 14));
+}
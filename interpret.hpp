@@ -0,0 +1,710 @@
+/*
+ * This file is part of PrefixTree
+ *
+ * The MIT License (MIT)
+ * 
+ * Copyright (c) 2016 Jon Chesterfield
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifndef INTERPRET_HPP
+#define INTERPRET_HPP
+
+#include "prefix.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+
+namespace prefix
+{
+// One node of the trie of a table. Nodes are in pre-order, root first.
+// The children of a node take count adjacent slots from first, in order
+// of their edge character, and slots follow the order of their parents
+struct interpreted_node
+{
+  unsigned first;  // Slot of the first child
+  unsigned count;  // Children
+  unsigned row;    // Row ending at this node, or the table's fail()
+};
+
+// A trie as interpret walks it
+struct interpreted_trie
+{
+  const interpreted_node* nodes;
+  const unsigned char* edges;  // Character leading to the child in each slot
+  const unsigned* children;    // Node in each slot
+};
+
+// Slot of the child of x reached by c, or none
+inline const unsigned char* interpreted_edge(const interpreted_trie& trie,
+                                             const interpreted_node& x,
+                                             unsigned char c)
+{
+  const unsigned char* e = trie.edges + x.first;
+  const unsigned char* end = e + x.count;
+  if (x.count <= 8)
+    {
+      while (e != end && *e < c)
+        {
+          e++;
+        }
+    }
+  else
+    {
+      e = std::lower_bound(e, end, c);
+    }
+  return (e != end && *e == c) ? e : nullptr;
+}
+
+// The walk shared by every table, from node n with found the longest row
+// matched on the way there. Longest row that prefixes the first length
+// characters of key, or fail
+inline std::size_t interpret(const interpreted_trie& trie, std::size_t fail,
+                             const char* key, std::size_t length,
+                             std::size_t n, std::size_t found)
+{
+  for (std::size_t d = 0; d < length; d++)
+    {
+      const unsigned char* e = interpreted_edge(
+          trie, trie.nodes[n], static_cast<unsigned char>(key[d]));
+      if (e == nullptr)
+        {
+          break;
+        }
+      n = trie.children[e - trie.edges];
+      if (trie.nodes[n].row != fail)
+        {
+          found = trie.nodes[n].row;
+        }
+    }
+  return found;
+}
+
+inline std::size_t interpret(const interpreted_trie& trie, std::size_t fail,
+                             const char* key, std::size_t length)
+{
+  return interpret(trie, fail, key, length, 0, trie.nodes[0].row);
+}
+
+template <std::size_t... I>
+struct index_list
+{
+};
+
+template <typename X, typename Y>
+struct join_index_list;
+
+template <std::size_t... X, std::size_t... Y>
+struct join_index_list<index_list<X...>, index_list<Y...>>
+{
+  typedef index_list<X..., (sizeof...(X) + Y)...> type;
+};
+
+// index_list<0, 1, ... N - 1>, in log N steps of template depth
+template <std::size_t N>
+struct make_index_list
+{
+  typedef typename join_index_list<
+      typename make_index_list<N / 2>::type,
+      typename make_index_list<N - N / 2>::type>::type type;
+};
+
+template <>
+struct make_index_list<0>
+{
+  typedef index_list<> type;
+};
+
+template <>
+struct make_index_list<1>
+{
+  typedef index_list<0> type;
+};
+
+// Power of two above N
+constexpr std::size_t interpreted_width(std::size_t N, std::size_t W = 1)
+{
+  return (W > N) ? W : interpreted_width(N, 2 * W);
+}
+
+// Log two of a power of two
+constexpr unsigned interpreted_rank(std::size_t S)
+{
+  return (S <= 1) ? 0 : 1 + interpreted_rank(S / 2);
+}
+
+// Over an aligned block of rows, the nodes they first reach and the fewest
+// characters any of them shares with the row before it
+struct interpreted_block
+{
+  std::size_t added;
+  unsigned shared;
+};
+
+// Blocks of 2^K rows, for rows up to a power of two past the last
+template <typename T, unsigned K,
+          typename I = typename make_index_list<
+              (interpreted_width(T::size()) >> K)>::type>
+struct interpreted_blocks;
+
+template <typename T, typename I>
+struct interpreted_firsts;
+
+// Sums of children over blocks of 2^K nodes
+template <typename T, unsigned K,
+          typename I = typename make_index_list<
+              (interpreted_width(T::node_count()) >> K)>::type>
+struct interpreted_sums;
+
+template <typename T, typename I>
+struct interpreted_slot_firsts;
+
+template <typename T, typename I>
+struct interpreted_nodes;
+
+template <typename T, typename I>
+struct interpreted_edges;
+
+template <typename T, typename I>
+struct interpreted_children;
+
+// Lookup walking the trie of T held as constant data. The code per table
+// is a call to interpret, so large tables cost .rodata rather than text.
+// Matches as crtp::lookup_index_critbit
+template <typename T>
+class interpreted
+{
+ public:
+  static std::size_t lookup_index(const char* key)
+  {
+    return lookup_index(key, std::strlen(key) + 1);
+  }
+
+  static std::size_t lookup_index(const char* key, std::size_t length)
+  {
+    static_assert(T::template ordered<0, T::size()>(),
+                  "Table is not ordered - cannot search");
+    static_assert(T::node_count() < unsigned(-1) && T::size() < unsigned(-1),
+                  "Table too large for interpreted");
+    return T::instrumentation::template record<T>(
+        interpret(trie(), T::fail(), key, length), key, length);
+  }
+
+  // Lookup running the top unrolled() levels of the trie as code, one
+  // comparison per child as scan does, then walking nodes() below them.
+  // Most lookups resolve in the few levels near the root, which get the
+  // speed of code, while the rest of the table stays data. Matches as
+  // lookup_index
+  static std::size_t lookup_index_hybrid(const char* key)
+  {
+    return lookup_index_hybrid(key, std::strlen(key) + 1);
+  }
+
+  static std::size_t lookup_index_hybrid(const char* key, std::size_t length)
+  {
+    static_assert(T::template ordered<0, T::size()>(),
+                  "Table is not ordered - cannot search");
+    static_assert(T::node_count() < unsigned(-1) && T::size() < unsigned(-1),
+                  "Table too large for interpreted");
+    return T::instrumentation::template record<T>(
+        unroll<0, T::size(), 0>(key, length, T::fail()), key, length);
+  }
+
+  // Levels lookup_index_hybrid runs as code. T may give these as
+  //   static constexpr std::size_t unrolled = K;
+  // otherwise they are the most whose nodes number at most unroll_budget()
+  static constexpr std::size_t unrolled() { return unrolled_impl<T>(0); }
+
+  static constexpr std::size_t unroll_budget() { return 64; }
+
+  // The trie in pre-order, node_count() long. The root is node 0
+  static const interpreted_node* nodes()
+  {
+    return interpreted_nodes<
+        T, typename make_index_list<T::node_count()>::type>::values;
+  }
+
+  // Edges and children of each slot, node_count() long. Every node but the
+  // root takes one slot, so the last is unused
+  static const unsigned char* edges()
+  {
+    return interpreted_edges<
+        T, typename make_index_list<T::node_count()>::type>::values;
+  }
+
+  static const unsigned* children()
+  {
+    return interpreted_children<
+        T, typename make_index_list<T::node_count()>::type>::values;
+  }
+
+  static interpreted_trie trie()
+  {
+    return interpreted_trie{nodes(), edges(), children()};
+  }
+
+ private:
+  template <typename, unsigned, typename>
+  friend struct interpreted_blocks;
+  template <typename, typename>
+  friend struct interpreted_firsts;
+  template <typename, unsigned, typename>
+  friend struct interpreted_sums;
+  template <typename, typename>
+  friend struct interpreted_slot_firsts;
+  template <typename, typename>
+  friend struct interpreted_nodes;
+  template <typename, typename>
+  friend struct interpreted_edges;
+  template <typename, typename>
+  friend struct interpreted_children;
+
+  // The node array is built from sums and minimums over aligned power of
+  // two blocks of rows, held as one array per block size, and the slots
+  // from sums of children over blocks of nodes. Compilers do not reliably
+  // keep the constexpr calls they evaluate, so the builder only recurses
+  // to logarithmic depth over those arrays
+
+  static constexpr unsigned levels()
+  {
+    return interpreted_rank(interpreted_width(T::size()));
+  }
+
+  // Characters shared by rows X and Y
+  static constexpr std::size_t common(std::size_t X, std::size_t Y,
+                                      std::size_t I)
+  {
+    return (I < T::get(X).size() && I < T::get(Y).size() &&
+            T::get(X)[I] == T::get(Y)[I])
+               ? common(X, Y, I + 1)
+               : I;
+  }
+
+  // Row R alone. Past the last row shares no characters and adds no nodes
+  static constexpr interpreted_block leaf(std::size_t R)
+  {
+    return (R >= T::size())
+               ? interpreted_block{0, 0}
+               : (R == 0) ? interpreted_block{T::get(0).size(), 0}
+                          : interpreted_block{
+                                T::get(R).size() - common(R - 1, R, 0),
+                                static_cast<unsigned>(common(R - 1, R, 0))};
+  }
+
+  static constexpr interpreted_block join(interpreted_block X,
+                                          interpreted_block Y)
+  {
+    return interpreted_block{X.added + Y.added,
+                             (X.shared < Y.shared) ? X.shared : Y.shared};
+  }
+
+  // Block I of size 2^L
+  template <unsigned K>
+  static constexpr
+      typename std::enable_if<(K < levels()), interpreted_block>::type
+      block(unsigned L, std::size_t I)
+  {
+    return (L == K) ? interpreted_blocks<T, K>::values[I] : block<K + 1>(L, I);
+  }
+
+  template <unsigned K>
+  static constexpr
+      typename std::enable_if<(K == levels()), interpreted_block>::type
+      block(unsigned, std::size_t I)
+  {
+    return interpreted_blocks<T, K>::values[I];
+  }
+
+  // Over rows [L, L + S), for S a power of two and L a multiple of S
+  static constexpr interpreted_block block(std::size_t L, std::size_t S)
+  {
+    return block<0>(interpreted_rank(S), L / S);
+  }
+
+  // Characters row R shares with row R - 1
+  static constexpr unsigned shared(std::size_t R)
+  {
+    return block(R, 1).shared;
+  }
+
+  // Node first reached by row R. For R == size(), node_count()
+  static constexpr unsigned first(std::size_t R)
+  {
+    return (R == 0) ? 1 : first(R & (R - 1)) +
+                              block(R & (R - 1), R & (~R + 1)).added;
+  }
+
+  static constexpr unsigned firsts(std::size_t R)
+  {
+    return interpreted_firsts<
+        T, typename make_index_list<T::size() + 1>::type>::values[R];
+  }
+
+  // First row from R, with R a multiple of S, that shares fewer than D
+  // characters with the row before it. Past the last row shares none
+  static constexpr std::size_t fewer(std::size_t R, std::size_t D,
+                                     std::size_t S)
+  {
+    return (block(R, S).shared < D)
+               ? fewer_within(R, D, S)
+               : fewer(R + S, D, ((R + S) % (2 * S) == 0) ? 2 * S : S);
+  }
+
+  static constexpr std::size_t fewer_within(std::size_t R, std::size_t D,
+                                            std::size_t S)
+  {
+    return (S == 1) ? R : (block(R, S / 2).shared < D)
+                              ? fewer_within(R, D, S / 2)
+                              : fewer_within(R + S / 2, D, S / 2);
+  }
+
+  // Row in [L, U) that first reaches node N
+  static constexpr std::size_t row_of(std::size_t N, std::size_t L,
+                                      std::size_t U)
+  {
+    return (L + 1 == U) ? L : (firsts((L + U) / 2) <= N)
+                                  ? row_of(N, (L + U) / 2, U)
+                                  : row_of(N, L, (L + U) / 2);
+  }
+
+  // Row that first reaches node N, and the characters N stands for
+  static constexpr std::size_t row_at(std::size_t N)
+  {
+    return (N == 0) ? 0 : row_of(N, 0, T::size());
+  }
+
+  static constexpr std::size_t depth(std::size_t N)
+  {
+    return (N == 0) ? 0 : shared(row_at(N)) + (N - firsts(row_at(N))) + 1;
+  }
+
+  // First row past the subtree of the node for the first D characters of
+  // row R
+  static constexpr std::size_t subtree_end(std::size_t R, std::size_t D)
+  {
+    return (D == 0) ? T::size() : fewer(R + 1, D, 1);
+  }
+
+  // First row of the first child of that node, which may be past the end
+  static constexpr std::size_t first_child_row(std::size_t R, std::size_t D)
+  {
+    return (D < T::get(R).size()) ? R : R + 1;
+  }
+
+  // Children from the one starting at row X, up to row E
+  static constexpr std::size_t children_from(std::size_t X, std::size_t D,
+                                             std::size_t E)
+  {
+    return (X >= E) ? 0 : 1 + children_from(fewer(X + 1, D + 1, 1), D, E);
+  }
+
+  // First row of child K from the one starting at row X
+  static constexpr std::size_t child_row(std::size_t X, std::size_t D,
+                                         std::size_t K)
+  {
+    return (K == 0) ? X : child_row(fewer(X + 1, D + 1, 1), D, K - 1);
+  }
+
+  static constexpr std::size_t child_count(std::size_t N)
+  {
+    return (N >= T::node_count() || T::size() == 0)
+               ? 0
+               : children_from(first_child_row(row_at(N), depth(N)), depth(N),
+                               subtree_end(row_at(N), depth(N)));
+  }
+
+  static constexpr unsigned node_levels()
+  {
+    return interpreted_rank(interpreted_width(T::node_count()));
+  }
+
+  static constexpr std::size_t join_sums(std::size_t X, std::size_t Y)
+  {
+    return X + Y;
+  }
+
+  // Children of nodes block I of size 2^L
+  template <unsigned K>
+  static constexpr typename std::enable_if<(K < node_levels()),
+                                           std::size_t>::type
+  sum(unsigned L, std::size_t I)
+  {
+    return (L == K) ? interpreted_sums<T, K>::values[I] : sum<K + 1>(L, I);
+  }
+
+  template <unsigned K>
+  static constexpr typename std::enable_if<(K == node_levels()),
+                                           std::size_t>::type
+  sum(unsigned, std::size_t I)
+  {
+    return interpreted_sums<T, K>::values[I];
+  }
+
+  // Slots before those of node N's children
+  static constexpr std::size_t slot_first(std::size_t N)
+  {
+    return (N == 0) ? 0
+                    : slot_first(N & (N - 1)) +
+                          sum<0>(interpreted_rank(N & (~N + 1)),
+                                 (N & (N - 1)) / (N & (~N + 1)));
+  }
+
+  static constexpr unsigned slot_firsts(std::size_t N)
+  {
+    return interpreted_slot_firsts<
+        T, typename make_index_list<T::node_count() + 1>::type>::values[N];
+  }
+
+  // Node in [L, U) whose children take slot S
+  static constexpr std::size_t parent_of(std::size_t S, std::size_t L,
+                                         std::size_t U)
+  {
+    return (L + 1 == U) ? L : (slot_firsts((L + U) / 2) <= S)
+                                  ? parent_of(S, (L + U) / 2, U)
+                                  : parent_of(S, L, (L + U) / 2);
+  }
+
+  // First row of the child in slot S, a child of node P
+  static constexpr std::size_t slot_row(std::size_t S, std::size_t P)
+  {
+    return child_row(first_child_row(row_at(P), depth(P)), depth(P),
+                     S - slot_firsts(P));
+  }
+
+  static constexpr unsigned char slot_edge(std::size_t S, std::size_t P)
+  {
+    return static_cast<unsigned char>(T::get(slot_row(S, P))[depth(P)]);
+  }
+
+  static constexpr unsigned char edge(std::size_t S)
+  {
+    return (S + 1 >= T::node_count())
+               ? 0
+               : slot_edge(S, parent_of(S, 0, T::node_count()));
+  }
+
+  static constexpr unsigned child(std::size_t S)
+  {
+    return (S + 1 >= T::node_count())
+               ? 0
+               : static_cast<unsigned>(node_index(
+                     slot_row(S, parent_of(S, 0, T::node_count())),
+                     depth(parent_of(S, 0, T::node_count())) + 1));
+  }
+
+  static constexpr interpreted_node node(std::size_t N)
+  {
+    return interpreted_node{
+        slot_firsts(N), static_cast<unsigned>(child_count(N)),
+        static_cast<unsigned>((T::size() != 0 &&
+                               T::get(row_at(N)).size() == depth(N))
+                                  ? row_at(N)
+                                  : T::fail())};
+  }
+
+  // Node for the first D characters of row R, where R is the first row
+  // with that prefix
+  static constexpr std::size_t node_index(std::size_t R, std::size_t D)
+  {
+    return (D == 0) ? 0 : firsts(R) + (D - shared(R) - 1);
+  }
+
+  // Nodes at depth at most D, from rows [L, U)
+  static constexpr std::size_t nodes_within(std::size_t D, std::size_t L,
+                                            std::size_t U)
+  {
+    return (L + 1 == U)
+               ? ((T::get(L).size() < D) ? T::get(L).size() : D) -
+                     ((shared(L) < D) ? shared(L) : D)
+               : nodes_within(D, L, (L + U) / 2) +
+                     nodes_within(D, (L + U) / 2, U);
+  }
+
+  static constexpr std::size_t longest(std::size_t L, std::size_t U)
+  {
+    return (L + 1 == U) ? T::get(L).size()
+                        : (longest(L, (L + U) / 2) > longest((L + U) / 2, U))
+                              ? longest(L, (L + U) / 2)
+                              : longest((L + U) / 2, U);
+  }
+
+  static constexpr std::size_t unrolled_from(std::size_t D)
+  {
+    return (D < longest(0, T::size()) &&
+            1 + nodes_within(D + 1, 0, T::size()) <= unroll_budget())
+               ? unrolled_from(D + 1)
+               : D;
+  }
+
+  template <typename X>
+  static constexpr auto unrolled_impl(int) -> decltype(std::size_t(X::unrolled))
+  {
+    return X::unrolled;
+  }
+
+  template <typename X>
+  static constexpr std::size_t unrolled_impl(long)
+  {
+    return unrolled_from(0);
+  }
+
+  // First row in [L, U) with a different character at D to row L
+  static constexpr std::size_t group_end(std::size_t L, std::size_t U,
+                                         std::size_t D)
+  {
+    return (L + 1 == U) ? U : (T::get((L + U) / 2)[D] == T::get(L)[D])
+                                  ? group_end((L + U) / 2, U, D)
+                                  : group_end(L, (L + U) / 2, D);
+  }
+
+  // Rows [L, U) share their first D characters. Row L is that prefix
+  // when it ends at D
+  template <std::size_t L, std::size_t U, std::size_t D>
+  static std::size_t unroll(const char* key, std::size_t length,
+                            std::size_t found)
+  {
+    return unroll_node<L, U, D, (T::get(L).size() == D), (D < unrolled())>(
+        key, length, found);
+  }
+
+  template <std::size_t L, std::size_t U, std::size_t D, bool END, bool CODE>
+  static typename std::enable_if<CODE, std::size_t>::type unroll_node(
+      const char* key, std::size_t length, std::size_t found)
+  {
+    return (D < length) ? children<L + END, U, D>(key, length, END ? L : found)
+                        : (END ? L : found);
+  }
+
+  template <std::size_t L, std::size_t U, std::size_t D, bool END, bool CODE>
+  static typename std::enable_if<!CODE, std::size_t>::type unroll_node(
+      const char* key, std::size_t length, std::size_t found)
+  {
+    return interpret(trie(), T::fail(), key + D, length - D,
+                     node_index(L, D), END ? L : found);
+  }
+
+  // One comparison per child of the node holding rows [L, U)
+  template <std::size_t L, std::size_t U, std::size_t D>
+  static typename std::enable_if<(L == U), std::size_t>::type children(
+      const char*, std::size_t, std::size_t found)
+  {
+    return found;
+  }
+
+  template <std::size_t L, std::size_t U, std::size_t D>
+  static typename std::enable_if<(L < U), std::size_t>::type children(
+      const char* key, std::size_t length, std::size_t found)
+  {
+    return (key[D] == T::get(L)[D])
+               ? unroll<L, group_end(L, U, D), D + 1>(key, length, found)
+               : children<group_end(L, U, D), U, D>(key, length, found);
+  }
+};
+
+template <typename T, std::size_t... B>
+struct interpreted_blocks<T, 0, index_list<B...>>
+{
+  static constexpr interpreted_block values[] = {interpreted<T>::leaf(B)...};
+};
+
+template <typename T, std::size_t... B>
+constexpr interpreted_block
+    interpreted_blocks<T, 0, index_list<B...>>::values[];
+
+template <typename T, unsigned K, std::size_t... B>
+struct interpreted_blocks<T, K, index_list<B...>>
+{
+  static constexpr interpreted_block values[] = {interpreted<T>::join(
+      interpreted_blocks<T, K - 1>::values[2 * B],
+      interpreted_blocks<T, K - 1>::values[2 * B + 1])...};
+};
+
+template <typename T, unsigned K, std::size_t... B>
+constexpr interpreted_block
+    interpreted_blocks<T, K, index_list<B...>>::values[];
+
+template <typename T, std::size_t... R>
+struct interpreted_firsts<T, index_list<R...>>
+{
+  static constexpr unsigned values[] = {interpreted<T>::first(R)...};
+};
+
+template <typename T, std::size_t... R>
+constexpr unsigned interpreted_firsts<T, index_list<R...>>::values[];
+
+template <typename T, std::size_t... B>
+struct interpreted_sums<T, 0, index_list<B...>>
+{
+  static constexpr std::size_t values[] = {interpreted<T>::child_count(B)...};
+};
+
+template <typename T, std::size_t... B>
+constexpr std::size_t interpreted_sums<T, 0, index_list<B...>>::values[];
+
+template <typename T, unsigned K, std::size_t... B>
+struct interpreted_sums<T, K, index_list<B...>>
+{
+  static constexpr std::size_t values[] = {interpreted<T>::join_sums(
+      interpreted_sums<T, K - 1>::values[2 * B],
+      interpreted_sums<T, K - 1>::values[2 * B + 1])...};
+};
+
+template <typename T, unsigned K, std::size_t... B>
+constexpr std::size_t interpreted_sums<T, K, index_list<B...>>::values[];
+
+template <typename T, std::size_t... N>
+struct interpreted_slot_firsts<T, index_list<N...>>
+{
+  static constexpr unsigned values[] = {
+      static_cast<unsigned>(interpreted<T>::slot_first(N))...};
+};
+
+template <typename T, std::size_t... N>
+constexpr unsigned interpreted_slot_firsts<T, index_list<N...>>::values[];
+
+template <typename T, std::size_t... N>
+struct interpreted_nodes<T, index_list<N...>>
+{
+  static constexpr interpreted_node values[] = {interpreted<T>::node(N)...};
+};
+
+template <typename T, std::size_t... N>
+constexpr interpreted_node interpreted_nodes<T, index_list<N...>>::values[];
+
+template <typename T, std::size_t... S>
+struct interpreted_edges<T, index_list<S...>>
+{
+  static constexpr unsigned char values[] = {interpreted<T>::edge(S)...};
+};
+
+template <typename T, std::size_t... S>
+constexpr unsigned char interpreted_edges<T, index_list<S...>>::values[];
+
+template <typename T, std::size_t... S>
+struct interpreted_children<T, index_list<S...>>
+{
+  static constexpr unsigned values[] = {interpreted<T>::child(S)...};
+};
+
+template <typename T, std::size_t... S>
+constexpr unsigned interpreted_children<T, index_list<S...>>::values[];
+}
+
+#endif  // INTERPRET_HPP
@@ -0,0 +1,324 @@
+// Counts, or prints the lines holding, the keys of a compile time table in
+// large files. Each file is mapped into memory and split at line breaks
+// into chunks, which a pool of threads takes in turn. Edit keys below and
+// rebuild to search for something else
+//   keygrep.exe [--lines] [--start] [--threads N] [--chunk BYTES]
+//               [--stats] FILE...
+#include "prefix.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace
+{
+struct keys : prefix::crtp<keys>
+{
+  static constexpr element table[] = {
+      "CRITICAL", "DEBUG", "ERROR", "FATAL", "INFO",
+      "PANIC",    "TRACE", "WARN",  "WARNING",
+  };
+};
+constexpr decltype(keys::table) keys::table;
+
+struct options
+{
+  bool lines = false;  // Print matching lines rather than counts
+  bool start = false;  // Only match at the start of a line
+  bool stats = false;  // Report throughput on stderr
+  unsigned threads = std::max(1u, std::thread::hardware_concurrency());
+  std::size_t chunk = std::size_t(1) << 22;
+  std::vector<const char*> files;
+};
+
+// A read only mapping of a whole file
+class mapping
+{
+ public:
+  explicit mapping(const char* path) : data(nullptr), length(0)
+  {
+    const int fd = open(path, O_RDONLY);
+    struct stat st;
+    if (fd < 0 || fstat(fd, &st) != 0)
+      {
+        if (fd >= 0)
+          {
+            close(fd);
+          }
+        return;
+      }
+    length = static_cast<std::size_t>(st.st_size);
+    if (length != 0)
+      {
+        void* p = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (p == MAP_FAILED)
+          {
+            length = 0;
+          }
+        else
+          {
+            data = static_cast<const char*>(p);
+            madvise(p, length, MADV_SEQUENTIAL);
+          }
+      }
+    opened = true;
+    close(fd);
+  }
+
+  ~mapping()
+  {
+    if (data)
+      {
+        munmap(const_cast<char*>(data), length);
+      }
+  }
+
+  mapping(const mapping&) = delete;
+  mapping& operator=(const mapping&) = delete;
+
+  bool ok() const { return opened && (data || length == 0); }
+
+  const char* data;
+  std::size_t length;
+
+ private:
+  bool opened = false;
+};
+
+struct chunk
+{
+  const char* begin;
+  const char* end;
+  std::vector<std::size_t> counts;
+  std::string out;  // Matching lines, when printing them, until written
+};
+
+// Splits [data, data + length) into pieces of about size bytes, each
+// ending after a line break or at the end of the file
+std::vector<chunk> split(const char* data, std::size_t length,
+                         std::size_t size)
+{
+  std::vector<chunk> chunks;
+  const char* end = data + length;
+  for (const char* begin = data; begin < end;)
+    {
+      const char* stop = begin + std::min(size, std::size_t(end - begin));
+      if (stop < end)
+        {
+          const void* nl = std::memchr(stop, '\n', end - stop);
+          stop = nl ? static_cast<const char*>(nl) + 1 : end;
+        }
+      chunks.push_back(chunk{begin, stop, {}, {}});
+      begin = stop;
+    }
+  return chunks;
+}
+
+// Keys in one line. Returns whether any matched
+bool scan_line(const char* line, std::size_t length, bool start,
+               std::vector<std::size_t>& counts)
+{
+  bool any = false;
+  for (std::size_t i = 0; i < length; i++)
+    {
+      const std::size_t index =
+          keys::lookup_index_critbit(line + i, length - i);
+      if (index != keys::fail())
+        {
+          counts[index]++;
+          any = true;
+          // Resume after the key, so keys that prefix one another count once
+          i += keys::get(index).size() - 1;
+        }
+      if (start)
+        {
+          break;
+        }
+    }
+  return any;
+}
+
+void scan_chunk(chunk& c, const options& opt)
+{
+  c.counts.assign(keys::size(), 0);
+  for (const char* line = c.begin; line < c.end;)
+    {
+      const void* nl = std::memchr(line, '\n', c.end - line);
+      const char* next = nl ? static_cast<const char*>(nl) + 1 : c.end;
+      const std::size_t length = (nl ? next - 1 : next) - line;
+      if (scan_line(line, length, opt.start, c.counts) && opt.lines)
+        {
+          c.out.append(line, next - line);
+          if (!nl)
+            {
+              c.out += '\n';
+            }
+        }
+      line = next;
+    }
+}
+
+// Chunks are taken in turn from a shared counter, so a thread held up by
+// a slow chunk or page faults does not hold the others back. The lines of
+// each chunk are written as soon as it and every chunk before it are
+// done, and no thread takes a chunk more than a window ahead of the
+// writer, so output starts early and memory stays bounded. Returns the
+// number of threads used
+unsigned run(std::vector<chunk>& chunks, const options& opt)
+{
+  const unsigned threads =
+      static_cast<unsigned>(std::min<std::size_t>(opt.threads, chunks.size()));
+  const std::size_t window = 4 * std::size_t(threads);
+  std::atomic<std::size_t> taken(0);
+  std::mutex m;
+  std::condition_variable written;
+  std::size_t cursor = 0;                 // First chunk not yet written
+  std::vector<bool> done(chunks.size());  // Guarded by m, as is cursor
+  auto work = [&]() {
+    for (std::size_t i; (i = taken.fetch_add(1)) < chunks.size();)
+      {
+        {
+          std::unique_lock<std::mutex> lock(m);
+          written.wait(lock, [&] { return i < cursor + window; });
+        }
+        scan_chunk(chunks[i], opt);
+        std::lock_guard<std::mutex> lock(m);
+        done[i] = true;
+        const std::size_t first = cursor;
+        for (; cursor < chunks.size() && done[cursor]; cursor++)
+          {
+            std::string& out = chunks[cursor].out;
+            std::fwrite(out.data(), 1, out.size(), stdout);
+            std::string().swap(out);
+          }
+        if (cursor != first)
+          {
+            written.notify_all();
+          }
+      }
+  };
+  std::vector<std::thread> pool;
+  for (unsigned t = 1; t < threads; t++)
+    {
+      pool.emplace_back(work);
+    }
+  work();
+  for (std::thread& t : pool)
+    {
+      t.join();
+    }
+  return threads;
+}
+
+bool parse(int argc, char** argv, options& opt)
+{
+  for (int i = 1; i < argc; i++)
+    {
+      const bool more = i + 1 < argc;
+      if (!std::strcmp(argv[i], "--lines"))
+        {
+          opt.lines = true;
+        }
+      else if (!std::strcmp(argv[i], "--start"))
+        {
+          opt.start = true;
+        }
+      else if (!std::strcmp(argv[i], "--stats"))
+        {
+          opt.stats = true;
+        }
+      else if (more && !std::strcmp(argv[i], "--threads"))
+        {
+          opt.threads = std::max(1, std::atoi(argv[++i]));
+        }
+      else if (more && !std::strcmp(argv[i], "--chunk"))
+        {
+          opt.chunk = std::max(1ul, std::strtoul(argv[++i], nullptr, 10));
+        }
+      else if (argv[i][0] != '-')
+        {
+          opt.files.push_back(argv[i]);
+        }
+      else
+        {
+          opt.files.clear();
+          break;
+        }
+    }
+  if (opt.files.empty())
+    {
+      std::fprintf(stderr,
+                   "Usage: %s [--lines] [--start] [--threads N] "
+                   "[--chunk BYTES] [--stats] FILE...\n",
+                   argv[0]);
+      return false;
+    }
+  return true;
+}
+}
+
+int main(int argc, char** argv)
+{
+  options opt;
+  if (!parse(argc, argv, opt))
+    {
+      return 2;
+    }
+
+  typedef std::chrono::steady_clock clock;
+  const clock::time_point begin = clock::now();
+  std::vector<std::size_t> totals(keys::size(), 0);
+  std::size_t bytes = 0;
+  unsigned used = 0;  // Most threads any file was scanned with
+  int status = 0;
+  for (const char* path : opt.files)
+    {
+      const mapping file(path);
+      if (!file.ok())
+        {
+          std::fprintf(stderr, "Cannot read %s\n", path);
+          status = 2;
+          continue;
+        }
+      std::vector<chunk> chunks = split(file.data, file.length, opt.chunk);
+      used = std::max(used, run(chunks, opt));
+      for (const chunk& c : chunks)
+        {
+          for (std::size_t k = 0; k < keys::size(); k++)
+            {
+              totals[k] += c.counts[k];
+            }
+        }
+      bytes += file.length;
+    }
+  const double seconds =
+      std::chrono::duration<double>(clock::now() - begin).count();
+
+  if (!opt.lines)
+    {
+      for (std::size_t k = 0; k < keys::size(); k++)
+        {
+          std::printf("%-10s %zu\n", keys::get(k).data(), totals[k]);
+        }
+    }
+  if (opt.stats)
+    {
+      std::fprintf(stderr, "%zu bytes in %.3fs, %.1f MB/s on %u threads\n",
+                   bytes, seconds, bytes / seconds / 1e6, used);
+    }
+  return status;
+}
@@ -0,0 +1,40 @@
+#!/usr/bin/env python3
+# Synthetic application log for keygrep.exe, a level and a message per
+# line, e.g. python3 keygrep_log.py --mb 64 > keygrep.log
+
+import argparse
+import random
+import sys
+
+LEVELS = ["INFO"] * 60 + ["DEBUG"] * 25 + ["WARN"] * 8 + ["WARNING"] * 3 + \
+         ["ERROR"] * 3 + ["FATAL", "TRACE"]
+WORDS = ["request", "served", "user", "session", "cache", "miss", "timeout",
+         "retry", "connection", "closed", "upstream", "latency", "ms", "id",
+         "queue", "depth", "worker", "started", "stopped", "ERROR", "Info"]
+
+
+def main():
+    parser = argparse.ArgumentParser()
+    parser.add_argument("--mb", type=int, default=64)
+    parser.add_argument("--seed", type=int, default=1)
+    args = parser.parse_args()
+
+    rng = random.Random(args.seed)
+    limit = args.mb << 20
+    written = 0
+    out = []
+    while written < limit:
+        line = "2016-01-01T00:00:%02d.%06d %s [%s] %s\n" % (
+            rng.randrange(60), rng.randrange(1000000), rng.choice(LEVELS),
+            "worker-%d" % rng.randrange(64),
+            " ".join(rng.choice(WORDS) for _ in range(rng.randrange(4, 16))))
+        out.append(line)
+        written += len(line)
+        if len(out) == 4096:
+            sys.stdout.write("".join(out))
+            out = []
+    sys.stdout.write("".join(out))
+
+
+if __name__ == "__main__":
+    main()
@@ -450,3 +450,195 @@ TEST_CASE("common_prefix_regression")
   // CHECK(15886070940351924572u == *common_prefix_regression::lookup("\xb9"));
   CHECK(16229721192883529338u == *common_prefix_regression::lookup("\xb9\x85"));
 }
+
+TEST_CASE("critbit agrees with scan")
+{
+  const char* keys[] = {"barz", "foo", "wombat", "badger", "", "fo", "foobar"};
+  for (const char* k : keys)
+    {
+      CHECK(simple::lookup_index(k) == simple::lookup_index_critbit(k));
+      CHECK(double_quad::lookup_index(k) ==
+            double_quad::lookup_index_critbit(k));
+      CHECK(simple_prefix::lookup_index(k) ==
+            simple_prefix::lookup_index_critbit(k));
+    }
+
+  CHECK(0 == single_zero::lookup_index_critbit(""));
+  CHECK(0 == single_zero::lookup_index_critbit("a"));
+  CHECK(1 == single_single::lookup_index_critbit("X"));
+
+  CHECK(0 == signed_regression::lookup_index_critbit(
+                 "\x10\x40\x80\x70\x40\x30\x60"));
+  CHECK(1 ==
+        signed_regression::lookup_index_critbit("\x30\x70\x10\x80\x50\x10"));
+  CHECK(2 == signed_regression::lookup_index_critbit(
+                 "\x40\x20\x50\x40\x30\x10\x10\x50"));
+  CHECK(3 == signed_regression::lookup_index_critbit("\x80\x10\x10\x40"));
+  CHECK(4 == signed_regression::lookup_index_critbit("\x80\x50\x30\x50"));
+  CHECK(5 == signed_regression::lookup_index_critbit("\x80\x50\x30\x51"));
+}
+
+TEST_CASE("critbit prefers the longest row")
+{
+  CHECK(0 == common_prefix_regression::lookup_index_critbit("\x9a\x50\x85\xa4"));
+  CHECK(1 == common_prefix_regression::lookup_index_critbit("\xb9"));
+  CHECK(1 == common_prefix_regression::lookup_index_critbit("\xb9\x86"));
+  CHECK(2 == common_prefix_regression::lookup_index_critbit("\xb9\x85"));
+  CHECK(3 == common_prefix_regression::lookup_index_critbit("\x9a\x50\x85"));
+}
+
+TEST_CASE("critbit with explicit length")
+{
+  static_assert(1 == simple::lookup_index_critbit("foo", 3), "");
+  static_assert(3 == simple::lookup_index_critbit("foo", 2), "");
+  static_assert(2 == simple::lookup_index_critbit("wombats", 7), "");
+  CHECK(0 == simple::lookup_index_critbit("barzoo", 4));
+  CHECK(3 == simple::lookup_index_critbit("barzoo", 3));
+}
+
+struct long_keys : prefix::crtp<long_keys>
+{
+  static constexpr element table[] = {
+      "content-encoding", "content-language", "content-length",
+      "content-type",     "context",          "cookie",
+  };
+};
+constexpr decltype(long_keys::table) long_keys::table;
+static_assert(long_keys::ordered<0, long_keys::size()>(), "Ordered");
+
+TEST_CASE("stride width")
+{
+  static_assert(2 == long_keys::stride_width(0, long_keys::size(), 0), "");
+  static_assert(1 == long_keys::stride_width(4, 5, 6), "");
+  static_assert(2 == long_keys::stride_width(0, 4, 8), "");
+  static_assert(1 == simple::stride_width(0, simple::size(), 3), "");
+}
+
+TEST_CASE("node count")
+{
+  static_assert(1 == single_zero::node_count(), "");
+  static_assert(2 == single_single::node_count(), "");
+  static_assert(14 == simple::node_count(), "");
+  static_assert(7 == double_quad::node_count(), "");
+  static_assert(40 == long_keys::node_count(), "");
+}
+
+TEST_CASE("stride agrees with critbit")
+{
+  const char* keys[] = {"barz",          "foo",
+                        "wombat",        "badger",
+                        "",              "fo",
+                        "foobar",        "content-type: text",
+                        "content-length", "content-lengthy",
+                        "content-lengt", "context",
+                        "contex",        "cookies",
+                        "coo",           "content-encodingX"};
+  for (const char* k : keys)
+    {
+      CHECK(simple::lookup_index_critbit(k) ==
+            simple::lookup_index_stride(k));
+      CHECK(simple_prefix::lookup_index_critbit(k) ==
+            simple_prefix::lookup_index_stride(k));
+      CHECK(long_keys::lookup_index_critbit(k) ==
+            long_keys::lookup_index_stride(k));
+    }
+  CHECK(3 == long_keys::lookup_index_stride("content-type"));
+  CHECK(4 == long_keys::lookup_index_stride("context"));
+  CHECK(6 == long_keys::lookup_index_stride("conte"));
+
+  CHECK(1 == common_prefix_regression::lookup_index_stride("\xb9"));
+  CHECK(2 == common_prefix_regression::lookup_index_stride("\xb9\x85"));
+  CHECK(0 == single_zero::lookup_index_stride(""));
+  CHECK(3 == signed_regression::lookup_index_stride("\x80\x10\x10\x40"));
+  CHECK(5 == signed_regression::lookup_index_stride("\x80\x10\x10"));
+}
+
+TEST_CASE("stride with explicit length")
+{
+  static_assert(3 == long_keys::lookup_index_stride("content-type", 12), "");
+  static_assert(6 == long_keys::lookup_index_stride("content-type", 11), "");
+  CHECK(5 == long_keys::lookup_index_stride("cookie", 6));
+  CHECK(6 == long_keys::lookup_index_stride("cookie", 5));
+}
+
+struct weighted_keys : prefix::crtp<weighted_keys>
+{
+  static constexpr element table[] = {
+      "content-encoding", "content-language", "content-length",
+      "content-type",     "context",          "cookie",
+  };
+  static constexpr unsigned weights[] = {1, 0, 2, 90, 3, 4};
+};
+constexpr decltype(weighted_keys::table) weighted_keys::table;
+constexpr decltype(weighted_keys::weights) weighted_keys::weights;
+static_assert(weighted_keys::ordered<0, weighted_keys::size()>(), "Ordered");
+
+TEST_CASE("weights")
+{
+  static_assert(1 == long_keys::weight(3), "");
+  static_assert(90 == weighted_keys::weight(3), "");
+  static_assert(100 == weighted_keys::weight_sum(0, weighted_keys::size()),
+                "");
+  static_assert(3 == weighted_keys::weight_median(0, weighted_keys::size()),
+                "");
+  // content-type holds most of the weight from its first character on
+  static_assert(0 == weighted_keys::heaviest_group(0, 6, 0), "");
+  static_assert(3 == weighted_keys::heaviest_group(0, 4, 8), "");
+  static_assert(weighted_keys::fail() == weighted_keys::heaviest_group(0, 2, 9),
+                "");
+  static_assert(long_keys::fail() == long_keys::heaviest_group(0, 4, 8), "");
+}
+
+TEST_CASE("weighted agrees with critbit")
+{
+  const char* keys[] = {"barz",          "foo",
+                        "wombat",        "badger",
+                        "",              "fo",
+                        "foobar",        "content-type: text",
+                        "content-length", "content-lengthy",
+                        "content-lengt", "context",
+                        "contex",        "cookies",
+                        "coo",           "content-encodingX"};
+  for (const char* k : keys)
+    {
+      CHECK(simple::lookup_index_critbit(k) ==
+            simple::lookup_index_weighted(k));
+      CHECK(simple_prefix::lookup_index_critbit(k) ==
+            simple_prefix::lookup_index_weighted(k));
+      CHECK(long_keys::lookup_index_critbit(k) ==
+            long_keys::lookup_index_weighted(k));
+      CHECK(long_keys::lookup_index_critbit(k) ==
+            weighted_keys::lookup_index_weighted(k));
+      CHECK(long_keys::lookup_index(k) == weighted_keys::lookup_index(k));
+    }
+  CHECK(1 == common_prefix_regression::lookup_index_weighted("\xb9"));
+  CHECK(2 == common_prefix_regression::lookup_index_weighted("\xb9\x85"));
+  CHECK(0 == single_zero::lookup_index_weighted(""));
+  CHECK(3 == signed_regression::lookup_index_weighted("\x80\x10\x10\x40"));
+  static_assert(3 == weighted_keys::lookup_index_weighted("content-type", 12),
+                "");
+  static_assert(6 == weighted_keys::lookup_index_weighted("content-type", 11),
+                "");
+}
+
+TEST_CASE("lookup column")
+{
+  static_assert(std::is_same<prefix::compact_index<weighted_keys>::type,
+                             uint8_t>::value,
+                "");
+  // content-type, context, nothing, cookies, content-length, empty
+  const char data[] = "content-typecontextxcookiescontent-length";
+  const int32_t offsets[] = {0, 12, 19, 20, 27, 41, 41};
+  uint8_t narrow[6];
+  uint64_t wide[6];
+  weighted_keys::lookup_column(data, offsets, 6, narrow);
+  weighted_keys::lookup_column(data, offsets, 6, wide);
+  const std::size_t expect[] = {3, 4, 6, 5, 2, 6};
+  for (std::size_t i = 0; i < 6; i++)
+    {
+      CHECK(expect[i] == narrow[i]);
+      CHECK(expect[i] == wide[i]);
+      CHECK(expect[i] == weighted_keys::lookup_index_critbit(
+                             data + offsets[i], offsets[i + 1] - offsets[i]));
+    }
+}
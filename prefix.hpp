@@ -30,9 +30,12 @@
 
 #include <cstddef>
 #include <cstdio>
+#include <cstring>
 #include <algorithm>
 #include <tuple>
 #include <cassert>
+#include <cstdint>
+#include <limits>
 #include <type_traits>
 
 namespace prefix
@@ -150,12 +153,30 @@ class iterator_impl
   const M* ptr;
 };
 
-template <typename T, typename V = external>
+// Instrumentation policy that records nothing, see instrument.hpp
+struct uninstrumented
+{
+  template <typename T>
+  static constexpr std::size_t record(std::size_t index, const char*)
+  {
+    return index;
+  }
+
+  template <typename T>
+  static constexpr std::size_t record(std::size_t index, const char*,
+                                      std::size_t)
+  {
+    return index;
+  }
+};
+
+template <typename T, typename V = external, typename IP = uninstrumented>
 class crtp
 {
  public:
   typedef str_const key_type;
   typedef V value_type;
+  typedef IP instrumentation;
   using element = member<value_type>;
   using iterator = iterator_impl<element, value_type>;
 
@@ -197,19 +218,27 @@ class crtp
   // Returned if lookup_index fails
   static constexpr std::size_t fail() { return size(); }
 
+  // Number of nodes in the trie of the table, the root and one per distinct
+  // prefix of a row. Each is a branch in the code scan unrolls
+  static constexpr std::size_t node_count()
+  {
+    return 1 + new_nodes(0, size());
+  }
+
   // Lookup index in table that matches key
   template <typename U>
   static constexpr typename std::enable_if<std::is_same<U, const char*>::value,
                                            std::size_t>::type
   lookup_index(U key)
   {
-    return lookup_index_impl(key);
+    return IP::template record<T>(lookup_index_impl(key), key);
   }
 
   template <std::size_t N>
   constexpr static std::size_t lookup_index(const char (&key)[N])
   {
-    return lookup_index_impl(str_const(key).data());
+    return IP::template record<T>(lookup_index_impl(str_const(key).data()),
+                                 key);
   }
 
   constexpr static std::size_t lookup_index_impl(const char* key)
@@ -218,6 +247,95 @@ class crtp
     return scan<0, size(), 0, max_key_size<0, size()>()>(key);
   }
 
+  // Lookup index by branching only on the characters that distinguish rows
+  // Characters shared by every remaining row are skipped, the row reached is
+  // then compared in full. Where rows prefix one another, the longest wins.
+  // The terminating '\0' counts towards length, as it does for scan
+  static std::size_t lookup_index_critbit(const char* key)
+  {
+    return lookup_index_critbit(key, std::strlen(key) + 1);
+  }
+
+  // As above, for a key of known length that need not be '\0' terminated
+  constexpr static std::size_t lookup_index_critbit(const char* key,
+                                                    std::size_t length)
+  {
+    static_assert(ordered<0, size()>(), "Table is not ordered - cannot search");
+    return IP::template record<T>(critbit<0, size()>(key, length), key, length);
+  }
+
+  // Lookup index walking the trie one or two characters per node
+  // Nodes where every row has two more characters and the pairs are few
+  // compare sixteen bits at once, halving the depth of dependent branches.
+  // Matches as lookup_index_critbit
+  static std::size_t lookup_index_stride(const char* key)
+  {
+    return lookup_index_stride(key, std::strlen(key) + 1);
+  }
+
+  constexpr static std::size_t lookup_index_stride(const char* key,
+                                                   std::size_t length)
+  {
+    static_assert(ordered<0, size()>(), "Table is not ordered - cannot search");
+    return IP::template record<T>(stride<0, size(), 0>(key, length), key,
+                                 length);
+  }
+
+  // Lookup index as lookup_index_critbit, with the branches arranged by how
+  // often each row is expected to match. T gives these as
+  //   static constexpr unsigned weights[] = {...};
+  // one per row of the table, e.g. from a profile. A character holding over
+  // half the weight of a node is tested first, the remainder are split
+  // where the weight either side is closest to even. Without weights every
+  // row counts the same
+  static std::size_t lookup_index_weighted(const char* key)
+  {
+    return lookup_index_weighted(key, std::strlen(key) + 1);
+  }
+
+  constexpr static std::size_t lookup_index_weighted(const char* key,
+                                                     std::size_t length)
+  {
+    static_assert(ordered<0, size()>(), "Table is not ordered - cannot search");
+    static_assert(weights_fit<T>(0), "Need one weight per row");
+    return IP::template record<T>(weighted<0, size()>(key, length), key,
+                                  length);
+  }
+
+  // Index of each of count strings held column wise, as an Arrow string
+  // array is. String i is data[offsets[i]] up to data[offsets[i + 1]], so
+  // offsets holds count + 1 entries. Indices are written densely to out in
+  // type I, which must hold fail(), e.g. compact_index<T>. Matches as
+  // lookup_index_critbit with an explicit length
+  template <typename I, typename O>
+  static void lookup_column(const char* data, const O* offsets,
+                            std::size_t count, I* out)
+  {
+    static_assert(ordered<0, size()>(), "Table is not ordered - cannot search");
+    static_assert(std::is_integral<I>::value &&
+                      fail() <= std::size_t(std::numeric_limits<I>::max()),
+                  "Index type too narrow for table");
+    // Strings a few ahead are fetched while the current one is matched
+    const std::size_t ahead = 8;
+    for (std::size_t i = 0; i < count; i++)
+      {
+        if (i + ahead < count)
+          {
+            __builtin_prefetch(data + offsets[i + ahead]);
+          }
+        const std::size_t index =
+            lookup_index_critbit(data + offsets[i],
+                                 std::size_t(offsets[i + 1] - offsets[i]));
+        out[i] = static_cast<I>(index);
+      }
+  }
+
+  // Weight of row R, 1 if the table gives none
+  static constexpr std::size_t weight(std::size_t R)
+  {
+    return weight_impl<T>(R, 0);
+  }
+
   static constexpr iterator begin() { return iterator(&T::table[0]); }
 
   static constexpr iterator end() { return begin() + size(); }
@@ -674,8 +792,27 @@ class crtp
     static_assert(L + 1 < U, "Bounds wrong");
     static_assert(I <= IMAX, "");
 
-    return switch_lookup<L, U, I, IMAX, smallest_char<L, U, I>(),
-                         largest_char<L, U, I>()>(key);
+    return scan_hot<L, U, I, IMAX, SC, MC, heaviest_group(L, U, I)>(key);
+  }
+
+  // Test the character holding most of the weight before the rest, when
+  // the table gives weights and there is such a character
+  template <std::size_t L, std::size_t U, std::size_t I, std::size_t IMAX,
+            char SC, char MC, std::size_t H>
+  static constexpr typename std::enable_if<(H == fail()), std::size_t>::type
+  scan_hot(const char* key)
+  {
+    return switch_lookup<L, U, I, IMAX, SC, MC>(key);
+  }
+
+  template <std::size_t L, std::size_t U, std::size_t I, std::size_t IMAX,
+            char SC, char MC, std::size_t H>
+  static constexpr typename std::enable_if<(H != fail()), std::size_t>::type
+  scan_hot(const char* key)
+  {
+    return __builtin_expect(key[I] == getchar<H, I>(), 1)
+               ? n<L, U, I, IMAX, getchar<H, I>()>(key)
+               : switch_lookup<L, U, I, IMAX, SC, MC>(key);
   }
 
   template <std::size_t L, std::size_t U, std::size_t I, std::size_t IMAX>
@@ -688,6 +825,481 @@ class crtp
     return scan_narrow<L, U, I, IMAX, smallest_char<L, U, I>(),
                        largest_char<L, U, I>()>(key);
   }
+
+  // Character of row R at position I, as sorted by ordered
+  static constexpr unsigned char byte(std::size_t R, std::size_t I)
+  {
+    return static_cast<unsigned char>(get(R)[I]);
+  }
+
+  // Number of leading characters shared by rows X and Y, starting from I
+  static constexpr std::size_t common_prefix(std::size_t X, std::size_t Y,
+                                             std::size_t I)
+  {
+    return (I < get(X).size() && I < get(Y).size() && get(X)[I] == get(Y)[I])
+               ? common_prefix(X, Y, I + 1)
+               : I;
+  }
+
+  // Nodes added by rows [L, U) to the trie of the rows before L
+  static constexpr std::size_t new_nodes(std::size_t L, std::size_t U)
+  {
+    return (L == U) ? 0 : (L + 1 == U)
+                              ? get(L).size() -
+                                    ((L == 0) ? 0 : common_prefix(L - 1, L, 0))
+                              : new_nodes(L, (L + U) / 2) +
+                                    new_nodes((L + U) / 2, U);
+  }
+
+  // The S characters of row R from position I as one big endian value
+  static constexpr unsigned unit(std::size_t R, std::size_t I, std::size_t S)
+  {
+    return (S == 1) ? byte(R, I) : (unsigned(byte(R, I)) << 8) | byte(R, I + 1);
+  }
+
+  template <std::size_t S>
+  static constexpr unsigned key_unit(const char* key, std::size_t I)
+  {
+    return (S == 1) ? static_cast<unsigned char>(key[I])
+                    : (unsigned(static_cast<unsigned char>(key[I])) << 8) |
+                          static_cast<unsigned char>(key[I + 1]);
+  }
+
+  // First row in [L, U) whose unit at I is not less than C
+  static constexpr std::size_t group_lower(std::size_t L, std::size_t U,
+                                           std::size_t I, std::size_t S,
+                                           unsigned C)
+  {
+    return (L == U) ? L : (unit((L + U) / 2, I, S) < C)
+                              ? group_lower((L + U) / 2 + 1, U, I, S, C)
+                              : group_lower(L, (L + U) / 2, I, S, C);
+  }
+
+  // First row in [L, U) whose unit at I is greater than C
+  static constexpr std::size_t group_upper(std::size_t L, std::size_t U,
+                                           std::size_t I, std::size_t S,
+                                           unsigned C)
+  {
+    return (L == U) ? L : (C < unit((L + U) / 2, I, S))
+                              ? group_upper(L, (L + U) / 2, I, S, C)
+                              : group_upper((L + U) / 2 + 1, U, I, S, C);
+  }
+
+  // Split [L, U) on a group boundary near the middle. Requires > 1 group
+  static constexpr std::size_t group_split(std::size_t L, std::size_t U,
+                                           std::size_t I, std::size_t S)
+  {
+    return (group_lower(L, U, I, S, unit((L + U) / 2, I, S)) != L)
+               ? group_lower(L, U, I, S, unit((L + U) / 2, I, S))
+               : group_upper(L, U, I, S, unit((L + U) / 2, I, S));
+  }
+
+  // Compare the whole of row P against the key
+  template <std::size_t P, std::size_t I, std::size_t PSZ>
+  static constexpr typename std::enable_if<(I == PSZ), bool>::type
+  critbit_equal(const char*)
+  {
+    return true;
+  }
+
+  template <std::size_t P, std::size_t I, std::size_t PSZ>
+  static constexpr typename std::enable_if<(I < PSZ), bool>::type
+  critbit_equal(const char* key)
+  {
+    return getchar<P, I>() == key[I] && critbit_equal<P, I + 1, PSZ>(key);
+  }
+
+  template <std::size_t L, std::size_t U>
+  static constexpr typename std::enable_if<(L == U), std::size_t>::type
+  critbit(const char*, std::size_t)
+  {
+    return fail();
+  }
+
+  // Narrowed down to a single row, which has not been checked at all yet
+  template <std::size_t L, std::size_t U>
+  static constexpr typename std::enable_if<(L + 1 == U), std::size_t>::type
+  critbit(const char* key, std::size_t length)
+  {
+    return (get<L>().size() <= length &&
+            critbit_equal<L, 0, get<L>().size()>(key))
+               ? L
+               : fail();
+  }
+
+  // Every row in [L, U) shares the first D characters, and L is the shortest
+  // If L is exactly D long it is a prefix of the rest, used if they all miss
+  template <std::size_t L, std::size_t U, std::size_t D, std::size_t LSZ>
+  static constexpr typename std::enable_if<(D == LSZ), std::size_t>::type
+  critbit_node(const char* key, std::size_t length)
+  {
+    return critbit_or<L>(
+        (D < length) ? critbit_branch<L + 1, U, D>(key, length) : fail(), key,
+        length);
+  }
+
+  template <std::size_t L, std::size_t U, std::size_t D, std::size_t LSZ>
+  static constexpr typename std::enable_if<(D < LSZ), std::size_t>::type
+  critbit_node(const char* key, std::size_t length)
+  {
+    return (D < length) ? critbit_branch<L, U, D>(key, length) : fail();
+  }
+
+  template <std::size_t L>
+  static constexpr std::size_t critbit_or(std::size_t found, const char* key,
+                                          std::size_t length)
+  {
+    return (found != fail()) ? found : critbit<L, L + 1>(key, length);
+  }
+
+  template <std::size_t L, std::size_t U>
+  static constexpr typename std::enable_if<(L + 1 < U), std::size_t>::type
+  critbit(const char* key, std::size_t length)
+  {
+    return critbit_node<L, U, common_prefix(L, U - 1, 0), get<L>().size()>(
+        key, length);
+  }
+
+  // Rows in [L, U) are all longer than D, choose between them on key[D]
+  template <std::size_t L, std::size_t U, std::size_t D>
+  static constexpr std::size_t critbit_branch(const char* key,
+                                              std::size_t length)
+  {
+    return critbit_group<L, U, D, (byte(L, D) == byte(U - 1, D))>(key,
+                                                                  length);
+  }
+
+  template <std::size_t L, std::size_t U, std::size_t D, bool SINGLE>
+  static constexpr typename std::enable_if<SINGLE, std::size_t>::type
+  critbit_group(const char* key, std::size_t length)
+  {
+    return (static_cast<unsigned char>(key[D]) == byte(L, D))
+               ? critbit<L, U>(key, length)
+               : fail();
+  }
+
+  template <std::size_t L, std::size_t U, std::size_t D, bool SINGLE>
+  static constexpr typename std::enable_if<!SINGLE, std::size_t>::type
+  critbit_group(const char* key, std::size_t length)
+  {
+    return critbit_split<L, U, D, group_split(L, U, D, 1)>(key, length);
+  }
+
+  template <std::size_t L, std::size_t U, std::size_t D, std::size_t S>
+  static constexpr std::size_t critbit_split(const char* key,
+                                             std::size_t length)
+  {
+    static_assert(L < S && S < U, "Split does not divide the range");
+    return (static_cast<unsigned char>(key[D]) < byte(S, D))
+               ? critbit_branch<L, S, D>(key, length)
+               : critbit_branch<S, U, D>(key, length);
+  }
+
+  // Length of the shortest row in [L, U)
+  static constexpr std::size_t min_key_size(std::size_t L, std::size_t U)
+  {
+    return (L + 1 == U) ? get(L).size()
+                        : (min_key_size(L, (L + U) / 2) <
+                           min_key_size((L + U) / 2, U))
+                              ? min_key_size(L, (L + U) / 2)
+                              : min_key_size((L + U) / 2, U);
+  }
+
+  // Number of distinct units at I among rows [L, U)
+  static constexpr std::size_t distinct_units(std::size_t L, std::size_t U,
+                                              std::size_t I, std::size_t S)
+  {
+    return (L == U) ? 0 : 1 + distinct_units(group_upper(L, U, I, S,
+                                                         unit(L, I, S)),
+                                             U, I, S);
+  }
+
+  // Two characters per node when every row has them and a binary search
+  // over the pairs is no deeper than four compares
+  static constexpr std::size_t stride_width(std::size_t L, std::size_t U,
+                                            std::size_t I)
+  {
+    return (min_key_size(L, U) >= I + 2 && distinct_units(L, U, I, 2) <= 16)
+               ? 2
+               : 1;
+  }
+
+  template <std::size_t L, std::size_t U, std::size_t I>
+  static constexpr typename std::enable_if<(L == U), std::size_t>::type
+  stride(const char*, std::size_t)
+  {
+    return fail();
+  }
+
+  // Rows in [L, U) match the first I characters of the key
+  template <std::size_t L, std::size_t U, std::size_t I>
+  static constexpr typename std::enable_if<(L + 1 == U), std::size_t>::type
+  stride(const char* key, std::size_t length)
+  {
+    return (get<L>().size() <= length &&
+            critbit_equal<L, I, get<L>().size()>(key))
+               ? L
+               : fail();
+  }
+
+  template <std::size_t L, std::size_t U, std::size_t I>
+  static constexpr typename std::enable_if<(L + 1 < U), std::size_t>::type
+  stride(const char* key, std::size_t length)
+  {
+    return stride_node<L, U, I, get<L>().size(), stride_width(L, U, I)>(
+        key, length);
+  }
+
+  // Row L ends here, so matches if no longer row does
+  template <std::size_t L, std::size_t U, std::size_t I, std::size_t LSZ,
+            std::size_t S>
+  static constexpr typename std::enable_if<(I == LSZ), std::size_t>::type
+  stride_node(const char* key, std::size_t length)
+  {
+    return stride_or<L>((I < length) ? stride<L + 1, U, I>(key, length)
+                                     : fail());
+  }
+
+  template <std::size_t L, std::size_t U, std::size_t I, std::size_t LSZ,
+            std::size_t S>
+  static constexpr typename std::enable_if<(I < LSZ), std::size_t>::type
+  stride_node(const char* key, std::size_t length)
+  {
+    return (I + S <= length) ? stride_branch<L, U, I, S>(key, length) : fail();
+  }
+
+  template <std::size_t L>
+  static constexpr std::size_t stride_or(std::size_t found)
+  {
+    return (found != fail()) ? found : L;
+  }
+
+  template <std::size_t L, std::size_t U, std::size_t I, std::size_t S>
+  static constexpr std::size_t stride_branch(const char* key,
+                                             std::size_t length)
+  {
+    return stride_group<L, U, I, S, (unit(L, I, S) == unit(U - 1, I, S))>(
+        key, length);
+  }
+
+  template <std::size_t L, std::size_t U, std::size_t I, std::size_t S,
+            bool SINGLE>
+  static constexpr typename std::enable_if<SINGLE, std::size_t>::type
+  stride_group(const char* key, std::size_t length)
+  {
+    return (key_unit<S>(key, I) == unit(L, I, S))
+               ? stride<L, U, I + S>(key, length)
+               : fail();
+  }
+
+  template <std::size_t L, std::size_t U, std::size_t I, std::size_t S,
+            bool SINGLE>
+  static constexpr typename std::enable_if<!SINGLE, std::size_t>::type
+  stride_group(const char* key, std::size_t length)
+  {
+    return stride_split<L, U, I, S, group_split(L, U, I, S)>(key, length);
+  }
+
+  template <std::size_t L, std::size_t U, std::size_t I, std::size_t S,
+            std::size_t M>
+  static constexpr std::size_t stride_split(const char* key,
+                                            std::size_t length)
+  {
+    static_assert(L < M && M < U, "Split does not divide the range");
+    return (key_unit<S>(key, I) < unit(M, I, S))
+               ? stride_branch<L, M, I, S>(key, length)
+               : stride_branch<M, U, I, S>(key, length);
+  }
+
+  template <typename X>
+  static constexpr auto weight_impl(std::size_t R, int)
+      -> decltype(std::size_t(X::weights[0]))
+  {
+    return X::weights[R];
+  }
+
+  template <typename X>
+  static constexpr std::size_t weight_impl(std::size_t, long)
+  {
+    return 1;
+  }
+
+  template <typename X>
+  static constexpr auto weights_fit(int)
+      -> decltype(std::extent<decltype(X::weights)>::value, bool())
+  {
+    return std::extent<decltype(X::weights)>::value == size();
+  }
+
+  template <typename X>
+  static constexpr bool weights_fit(long)
+  {
+    return true;
+  }
+
+  template <typename X>
+  static constexpr auto has_weights(int)
+      -> decltype(std::size_t(X::weights[0]), bool())
+  {
+    return true;
+  }
+
+  template <typename X>
+  static constexpr bool has_weights(long)
+  {
+    return false;
+  }
+
+  // Total weight of rows [L, U)
+  static constexpr std::size_t weight_sum(std::size_t L, std::size_t U)
+  {
+    return (L == U) ? 0 : (L + 1 == U) ? weight(L)
+                                       : weight_sum(L, (L + U) / 2) +
+                                             weight_sum((L + U) / 2, U);
+  }
+
+  // Row in [L, U) at which the running weight from L passes W
+  static constexpr std::size_t weight_pivot(std::size_t L, std::size_t U,
+                                            std::size_t W)
+  {
+    return (L + 1 == U)
+               ? L
+               : (W < weight_sum(L, (L + U) / 2))
+                     ? weight_pivot(L, (L + U) / 2, W)
+                     : weight_pivot((L + U) / 2, U,
+                                    W - weight_sum(L, (L + U) / 2));
+  }
+
+  // The row at the middle of the weight of [L, U), or of the rows if none
+  static constexpr std::size_t weight_median(std::size_t L, std::size_t U)
+  {
+    return (weight_sum(L, U) == 0) ? (L + U) / 2
+                                   : weight_pivot(L, U, weight_sum(L, U) / 2);
+  }
+
+  // First row of the group with more than half the weight of the rows in
+  // [L, U) that have a character at I, or fail() if there is none or the
+  // table gives no weights. Such a group holds the weighted median
+  static constexpr std::size_t heaviest_group(std::size_t L, std::size_t U,
+                                              std::size_t I)
+  {
+    return (!has_weights<T>(0)) ? fail()
+                                : heaviest_from((get(L).size() > I) ? L : L + 1,
+                                                U, I);
+  }
+
+  static constexpr std::size_t heaviest_from(std::size_t L, std::size_t U,
+                                             std::size_t I)
+  {
+    return (L == U) ? fail() : heavy(L, U, I, byte(weight_median(L, U), I));
+  }
+
+  // First row of the group of [L, U) with C at I if it holds over half the
+  // weight
+  static constexpr std::size_t heavy(std::size_t L, std::size_t U,
+                                     std::size_t I, unsigned C)
+  {
+    return (2 * weight_sum(group_lower(L, U, I, 1, C),
+                           group_upper(L, U, I, 1, C)) > weight_sum(L, U))
+               ? group_lower(L, U, I, 1, C)
+               : fail();
+  }
+
+  template <std::size_t L, std::size_t U>
+  static constexpr typename std::enable_if<(L + 1 >= U), std::size_t>::type
+  weighted(const char* key, std::size_t length)
+  {
+    return critbit<L, U>(key, length);
+  }
+
+  template <std::size_t L, std::size_t U>
+  static constexpr typename std::enable_if<(L + 1 < U), std::size_t>::type
+  weighted(const char* key, std::size_t length)
+  {
+    return weighted_node<L, U, common_prefix(L, U - 1, 0), get<L>().size()>(
+        key, length);
+  }
+
+  // As critbit_node
+  template <std::size_t L, std::size_t U, std::size_t D, std::size_t LSZ>
+  static constexpr typename std::enable_if<(D == LSZ), std::size_t>::type
+  weighted_node(const char* key, std::size_t length)
+  {
+    return critbit_or<L>(
+        (D < length) ? weighted_branch<L + 1, U, D>(key, length) : fail(), key,
+        length);
+  }
+
+  template <std::size_t L, std::size_t U, std::size_t D, std::size_t LSZ>
+  static constexpr typename std::enable_if<(D < LSZ), std::size_t>::type
+  weighted_node(const char* key, std::size_t length)
+  {
+    return (D < length) ? weighted_branch<L, U, D>(key, length) : fail();
+  }
+
+  // Rows in [L, U) are all longer than D, choose between them on key[D]
+  template <std::size_t L, std::size_t U, std::size_t D>
+  static constexpr typename std::enable_if<(L == U), std::size_t>::type
+  weighted_branch(const char*, std::size_t)
+  {
+    return fail();
+  }
+
+  template <std::size_t L, std::size_t U, std::size_t D>
+  static constexpr typename std::enable_if<(L < U), std::size_t>::type
+  weighted_branch(const char* key, std::size_t length)
+  {
+    return weighted_group<
+        L, U, D, group_lower(L, U, D, 1, byte(weight_median(L, U), D)),
+        group_upper(L, U, D, 1, byte(weight_median(L, U), D))>(key, length);
+  }
+
+  // Group [GL, GU) holds the weighted median. Test it first if it holds
+  // most of the weight, otherwise split next to it
+  template <std::size_t L, std::size_t U, std::size_t D, std::size_t GL,
+            std::size_t GU>
+  static constexpr typename std::enable_if<
+      (2 * weight_sum(GL, GU) > weight_sum(L, U) || (GL == L && GU == U)),
+      std::size_t>::type
+  weighted_group(const char* key, std::size_t length)
+  {
+    return __builtin_expect(static_cast<unsigned char>(key[D]) == byte(GL, D),
+                            1)
+               ? weighted<GL, GU>(key, length)
+               : (static_cast<unsigned char>(key[D]) < byte(GL, D))
+                     ? weighted_branch<L, GL, D>(key, length)
+                     : weighted_branch<GU, U, D>(key, length);
+  }
+
+  template <std::size_t L, std::size_t U, std::size_t D, std::size_t GL,
+            std::size_t GU>
+  static constexpr typename std::enable_if<
+      !(2 * weight_sum(GL, GU) > weight_sum(L, U) || (GL == L && GU == U)),
+      std::size_t>::type
+  weighted_group(const char* key, std::size_t length)
+  {
+    return weighted_split<L, U, D, (GL != L) ? GL : GU>(key, length);
+  }
+
+  template <std::size_t L, std::size_t U, std::size_t D, std::size_t S>
+  static constexpr std::size_t weighted_split(const char* key,
+                                              std::size_t length)
+  {
+    static_assert(L < S && S < U, "Split does not divide the range");
+    return (static_cast<unsigned char>(key[D]) < byte(S, D))
+               ? weighted_branch<L, S, D>(key, length)
+               : weighted_branch<S, U, D>(key, length);
+  }
+};
+
+// Narrowest unsigned type holding every index of table T and its fail()
+template <typename T>
+struct compact_index
+{
+  typedef typename std::conditional<
+      (T::size() <= 0xffu), std::uint8_t,
+      typename std::conditional<(T::size() <= 0xffffu), std::uint16_t,
+                                std::uint32_t>::type>::type type;
 };
 }
 
@@ -0,0 +1,116 @@
+/*
+ * This file is part of PrefixTree
+ *
+ * The MIT License (MIT)
+ * 
+ * Copyright (c) 2016 Jon Chesterfield
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "rcu.hpp"
+#include "runtime.hpp"
+#include "catch.hpp"
+
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+// Counts live instances, to check retired versions are freed
+struct counted
+{
+  explicit counted(int v) : value(v) { live++; }
+  ~counted() { live--; }
+  int value;
+  static std::atomic<int> live;
+};
+std::atomic<int> counted::live(0);
+
+std::unique_ptr<const prefix::runtime_table> table(int version)
+{
+  const std::vector<std::string> rows = {"block",
+                                         "v" + std::to_string(version)};
+  return std::unique_ptr<const prefix::runtime_table>(
+      new prefix::runtime_table(rows));
+}
+}
+
+TEST_CASE("published frees versions no reader holds")
+{
+  {
+    prefix::published<counted> p(
+        std::unique_ptr<const counted>(new counted(0)));
+    CHECK(0 == p.read([](const counted& c) { return c.value; }));
+    {
+      const prefix::published<counted>::snapshot held(p);
+      p.publish(std::unique_ptr<const counted>(new counted(1)));
+      p.publish(std::unique_ptr<const counted>(new counted(2)));
+      // The held snapshot keeps version 0, and version 1 which was retired
+      // after it was taken
+      CHECK(0 == held->value);
+      CHECK(2 == p.read([](const counted& c) { return c.value; }));
+      CHECK(3 == counted::live);
+      CHECK(2 == p.reclaim());
+    }
+    CHECK(0 == p.reclaim());
+    CHECK(1 == counted::live);
+  }
+  CHECK(0 == counted::live);
+}
+
+TEST_CASE("published under concurrent readers")
+{
+  prefix::published<prefix::runtime_table> p(table(0));
+  std::atomic<bool> done(false);
+  std::atomic<unsigned> bad(0);
+  std::vector<std::thread> readers;
+  for (int t = 0; t < 4; t++)
+    {
+      readers.emplace_back([&] {
+        while (!done)
+          {
+            p.read([&](const prefix::runtime_table& r) {
+              // Every version holds block and one vN row
+              if (r.size() != 2 || r.lookup_index("blocked") != 0 ||
+                  r.get(1)[0] != 'v')
+                {
+                  bad++;
+                }
+              return 0;
+            });
+          }
+      });
+    }
+  for (int v = 1; v <= 200; v++)
+    {
+      p.publish(table(v));
+    }
+  done = true;
+  for (std::thread& t : readers)
+    {
+      t.join();
+    }
+  CHECK(0u == bad);
+  CHECK(0 == p.reclaim());
+  CHECK(1 == p.read([](const prefix::runtime_table& r) {
+          return r.lookup_index("v200");
+        }));
+}
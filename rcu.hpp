@@ -0,0 +1,275 @@
+/*
+ * This file is part of PrefixTree
+ *
+ * The MIT License (MIT)
+ * 
+ * Copyright (c) 2016 Jon Chesterfield
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifndef RCU_HPP
+#define RCU_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace prefix
+{
+// Deferred reclamation for structures read without locks. A reader
+// announces the epoch it started in, in one of a fixed set of slots,
+// before loading anything shared. A writer unlinks an object, then retires
+// it, tagged with the epoch at that moment, and advances the epoch. The
+// object is freed once every slot is idle or announces a later epoch, as
+// no reader can still hold it. Writers must be serialised by the caller,
+// and never wait for readers
+class epoch_domain
+{
+ private:
+  // Slot values below first are not epochs. A parked slot is held by a
+  // participant that is not reading
+  static constexpr std::uint64_t free = 0;
+  static constexpr std::uint64_t parked = 1;
+  static constexpr std::uint64_t first = 2;
+
+  struct alignas(64) slot
+  {
+    std::atomic<std::uint64_t> epoch;
+  };
+
+  struct retired_object
+  {
+    void* object;
+    void (*destroy)(void*);
+    std::uint64_t epoch;  // Readers from this epoch on cannot hold object
+  };
+
+ public:
+  // Up to slots readers at once. A guard waits for a slot to come free
+  explicit epoch_domain(std::size_t slots = 64)
+      : epoch(first), announced(slots)
+  {
+    for (slot& s : announced)
+      {
+        s.epoch.store(free, std::memory_order_relaxed);
+      }
+  }
+
+  epoch_domain(const epoch_domain&) = delete;
+  epoch_domain& operator=(const epoch_domain&) = delete;
+
+  // No reader may remain
+  ~epoch_domain()
+  {
+    for (const retired_object& r : retired)
+      {
+        r.destroy(r.object);
+      }
+  }
+
+  // Claims a free slot for the duration of one read
+  class guard
+  {
+   public:
+    explicit guard(const epoch_domain& d) : at(d.claim()) {}
+
+    ~guard() { at->epoch.store(free, std::memory_order_release); }
+
+    guard(const guard&) = delete;
+    guard& operator=(const guard&) = delete;
+
+   private:
+    slot* at;
+  };
+
+  // Holds a slot for as long as it lives, so that each read is two stores
+  // and a fence. One per reader thread
+  class participant
+  {
+   public:
+    explicit participant(const epoch_domain& d) : domain(d), at(d.claim())
+    {
+      at->epoch.store(parked, std::memory_order_release);
+    }
+
+    ~participant() { at->epoch.store(free, std::memory_order_release); }
+
+    participant(const participant&) = delete;
+    participant& operator=(const participant&) = delete;
+
+    void enter()
+    {
+      at->epoch.store(domain.epoch.load(), std::memory_order_relaxed);
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+    }
+
+    void leave() { at->epoch.store(parked, std::memory_order_release); }
+
+   private:
+    const epoch_domain& domain;
+    slot* at;
+  };
+
+  // Frees object with destroy once no reader can hold it. Call once it is
+  // unreachable for new readers
+  void retire(void* object, void (*destroy)(void*))
+  {
+    retired.push_back(retired_object{object, destroy, epoch.fetch_add(1)});
+  }
+
+  template <typename X>
+  void retire(const X* object)
+  {
+    retire(const_cast<X*>(object),
+           [](void* p) { delete static_cast<X*>(p); });
+  }
+
+  // Frees the retired objects no reader can hold. Returns how many wait
+  std::size_t reclaim()
+  {
+    // Orders the stores that unlinked retired objects before the slot
+    // loads, pairing with the fence or CAS a reader announces with. Either
+    // the scan sees the reader's epoch, or the reader sees the unlink
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    std::uint64_t oldest = UINT64_MAX;
+    for (const slot& s : announced)
+      {
+        const std::uint64_t e = s.epoch.load();
+        if (e >= first && e < oldest)
+          {
+            oldest = e;
+          }
+      }
+    std::size_t kept = 0;
+    for (const retired_object& r : retired)
+      {
+        if (r.epoch < oldest)
+          {
+            r.destroy(r.object);
+          }
+        else
+          {
+            retired[kept++] = r;
+          }
+      }
+    retired.resize(kept);
+    return kept;
+  }
+
+ private:
+  // A free slot, announcing the current epoch
+  slot* claim() const
+  {
+    const std::size_t n = announced.size();
+    std::size_t i = std::hash<std::thread::id>()(std::this_thread::get_id());
+    for (;; i++)
+      {
+        std::uint64_t expect = free;
+        if (announced[i % n].epoch.compare_exchange_weak(expect,
+                                                         epoch.load()))
+          {
+            return &announced[i % n];
+          }
+        if (i % n == n - 1)
+          {
+            std::this_thread::yield();
+          }
+      }
+  }
+
+  std::atomic<std::uint64_t> epoch;
+  mutable std::vector<slot> announced;
+  std::vector<retired_object> retired;
+};
+
+// Holds the current version of an immutable T, e.g. a runtime_table, for
+// readers that take no locks while a writer publishes replacements.
+// Replaced versions are freed through an epoch_domain
+template <typename T>
+class published
+{
+ public:
+  // Up to slots readers at once, more wait for a slot to come free
+  explicit published(std::unique_ptr<const T> initial,
+                     std::size_t slots = 64)
+      : current(initial.release()), domain(slots)
+  {
+  }
+
+  published(const published&) = delete;
+  published& operator=(const published&) = delete;
+
+  // No reader may remain
+  ~published() { delete current.load(); }
+
+  // The version current when it was taken, valid while the snapshot lives
+  class snapshot
+  {
+   public:
+    explicit snapshot(const published& p)
+        : claim(p.domain), version(p.current.load())
+    {
+    }
+
+    const T& operator*() const { return *version; }
+    const T* operator->() const { return version; }
+
+   private:
+    const epoch_domain::guard claim;
+    const T* version;
+  };
+
+  // f applied to the current version
+  template <typename F>
+  auto read(F f) const -> decltype(f(std::declval<const T&>()))
+  {
+    const snapshot s(*this);
+    return f(*s);
+  }
+
+  // Make next current. The version it replaces is freed once no reader
+  // can hold it, here or by a later publish or reclaim
+  void publish(std::unique_ptr<const T> next)
+  {
+    std::lock_guard<std::mutex> lock(writer);
+    domain.retire(current.exchange(next.release()));
+    domain.reclaim();
+  }
+
+  // Frees the retired versions no reader can hold. Returns how many wait
+  std::size_t reclaim()
+  {
+    std::lock_guard<std::mutex> lock(writer);
+    return domain.reclaim();
+  }
+
+ private:
+  std::atomic<const T*> current;
+  epoch_domain domain;
+  std::mutex writer;
+};
+}
+
+#endif  // RCU_HPP
@@ -0,0 +1,91 @@
+/*
+ * This file is part of PrefixTree
+ *
+ * The MIT License (MIT)
+ * 
+ * Copyright (c) 2016 Jon Chesterfield
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "runtime.hpp"
+#include "catch.hpp"
+
+#include <string>
+#include <vector>
+
+namespace
+{
+struct headers : prefix::crtp<headers>
+{
+  static constexpr element table[] = {
+      "",        "content-encoding", "content-language", "content-length",
+      "content-type", "context",     "cookie",           "\xff",
+  };
+};
+}
+constexpr decltype(headers::table) headers::table;
+
+TEST_CASE("runtime table matches crtp")
+{
+  // Unsorted, with a duplicate
+  const std::vector<std::string> rows = {
+      "cookie", "content-type", "\xff", "context", "content-encoding",
+      "",       "content-length", "content-language", "cookie"};
+  const prefix::runtime_table t(rows);
+  REQUIRE(headers::size() == t.size());
+  REQUIRE(headers::node_count() == t.node_count());
+  const prefix::interpreted_trie a = prefix::interpreted<headers>::trie();
+  const prefix::interpreted_trie b = t.trie();
+  for (std::size_t n = 0; n < t.node_count(); n++)
+    {
+      CHECK(a.nodes[n].first == b.nodes[n].first);
+      CHECK(a.nodes[n].count == b.nodes[n].count);
+      CHECK(a.nodes[n].row == b.nodes[n].row);
+    }
+  for (std::size_t s = 0; s + 1 < t.node_count(); s++)
+    {
+      CHECK(a.edges[s] == b.edges[s]);
+      CHECK(a.children[s] == b.children[s]);
+    }
+  for (std::size_t i = 0; i < t.size(); i++)
+    {
+      CHECK(t.get(i) == std::string(headers::get(i).data(),
+                                    headers::get(i).size()));
+    }
+  const char* keys[] = {"content-type: text", "content-length",
+                        "content-lengthy",    "content-lengt",
+                        "context",            "contex",
+                        "cookies",            "coo",
+                        "",                   "\xff\xff",
+                        "\xfe"};
+  for (const char* k : keys)
+    {
+      CHECK(headers::lookup_index_critbit(k) == t.lookup_index(k));
+    }
+  CHECK(3 == t.lookup_index("content-lengthy", 14));
+}
+
+TEST_CASE("runtime table without rows")
+{
+  const std::vector<std::string> none;
+  const prefix::runtime_table t(none);
+  CHECK(0 == t.size());
+  CHECK(1 == t.node_count());
+  CHECK(t.fail() == t.lookup_index("anything"));
+}
@@ -0,0 +1,136 @@
+/*
+ * This file is part of PrefixTree
+ *
+ * The MIT License (MIT)
+ * 
+ * Copyright (c) 2016 Jon Chesterfield
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifndef RUNTIME_HPP
+#define RUNTIME_HPP
+
+#include "interpret.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace prefix
+{
+// A table built at runtime, e.g. from a file, held as the pre-order nodes
+// and child slots interpreted<T> builds at compile time and walked by the same
+// interpret loop. Rows are sorted as crtp orders them, and lookups match
+// as crtp::lookup_index_critbit. Immutable once built
+class runtime_table
+{
+ public:
+  template <typename It>
+  runtime_table(It begin, It end) : rows(begin, end)
+  {
+    std::sort(rows.begin(), rows.end());
+    rows.erase(std::unique(rows.begin(), rows.end()), rows.end());
+    if (rows.size() >= unsigned(-1))
+      {
+        throw std::length_error("Too many rows for runtime_table");
+      }
+    build(0, rows.size(), 0);
+  }
+
+  explicit runtime_table(const std::vector<std::string>& keys)
+      : runtime_table(keys.begin(), keys.end())
+  {
+  }
+
+  std::size_t size() const { return rows.size(); }
+
+  // Returned if lookup_index fails
+  std::size_t fail() const { return size(); }
+
+  // Row i, in sorted order
+  const std::string& get(std::size_t i) const { return rows.at(i); }
+
+  std::size_t lookup_index(const char* key) const
+  {
+    return lookup_index(key, std::strlen(key) + 1);
+  }
+
+  std::size_t lookup_index(const char* key, std::size_t length) const
+  {
+    return interpret(trie(), fail(), key, length);
+  }
+
+  // The trie, as interpreted<T>::trie
+  interpreted_trie trie() const
+  {
+    return interpreted_trie{nodes.data(), edges.data(), children.data()};
+  }
+
+  std::size_t node_count() const { return nodes.size(); }
+
+ private:
+  // The node for the first D characters shared by rows [L, U), its
+  // children's slots, then its children in order
+  void build(std::size_t L, std::size_t U, std::size_t D)
+  {
+    if (nodes.size() >= unsigned(-1))
+      {
+        throw std::length_error("Too many nodes for runtime_table");
+      }
+    const std::size_t self = nodes.size();
+    nodes.push_back(interpreted_node{static_cast<unsigned>(edges.size()), 0,
+                                     static_cast<unsigned>(fail())});
+    if (L < U && rows[L].size() == D)
+      {
+        nodes[self].row = static_cast<unsigned>(L++);
+      }
+    for (std::size_t R = L; R < U; R++)
+      {
+        if (R == L || rows[R][D] != rows[R - 1][D])
+          {
+            edges.push_back(static_cast<unsigned char>(rows[R][D]));
+            nodes[self].count++;
+          }
+      }
+    children.resize(edges.size());
+    std::size_t slot = nodes[self].first;
+    while (L < U)
+      {
+        std::size_t E = L + 1;
+        while (E < U && rows[E][D] == rows[L][D])
+          {
+            E++;
+          }
+        children[slot++] = static_cast<unsigned>(nodes.size());
+        build(L, E, D + 1);
+        L = E;
+      }
+  }
+
+  std::vector<std::string> rows;
+  std::vector<interpreted_node> nodes;
+  std::vector<unsigned char> edges;
+  std::vector<unsigned> children;
+};
+}
+
+#endif  // RUNTIME_HPP
@@ -0,0 +1,125 @@
+/*
+ * This file is part of PrefixTree
+ *
+ * The MIT License (MIT)
+ * 
+ * Copyright (c) 2016 Jon Chesterfield
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "simd.hpp"
+#include "catch.hpp"
+
+namespace
+{
+struct methods : prefix::crtp<methods, int>
+{
+  static constexpr element table[] = {
+      {"CONNECT", 0}, {"DELETE", 1}, {"GET", 2},   {"HEAD", 3},
+      {"OPTIONS", 4}, {"PATCH", 5},  {"POST", 6},  {"PUT", 7},
+      {"TRACE", 8},
+  };
+};
+
+struct nested : prefix::crtp<nested>
+{
+  static constexpr element table[] = {
+      "", "a", "ab", "abcdefghijklmnop", "b\x80", "\xff",
+  };
+};
+}
+constexpr decltype(methods::table) methods::table;
+constexpr decltype(nested::table) nested::table;
+
+TEST_CASE("tiny agrees with critbit")
+{
+  const char* keys[] = {"GET /index.html", "PUT", "PU",      "POSTAL",
+                        "",                "get", "CONNECTED", "TRACE\0X",
+                        "DELETE ",         "HEADER"};
+  for (const char* k : keys)
+    {
+      CHECK(methods::lookup_index_critbit(k) ==
+            prefix::tiny<methods>::lookup_index(k));
+      CHECK(nested::lookup_index_critbit(k) ==
+            prefix::tiny<nested>::lookup_index(k));
+    }
+  CHECK(2 == prefix::tiny<methods>::lookup_index("GET"));
+  CHECK(9 == prefix::tiny<methods>::lookup_index("GE"));
+}
+
+TEST_CASE("tiny prefers the longest row")
+{
+  CHECK(0 == prefix::tiny<nested>::lookup_index(""));
+  CHECK(0 == prefix::tiny<nested>::lookup_index("c"));
+  CHECK(1 == prefix::tiny<nested>::lookup_index("a"));
+  CHECK(2 == prefix::tiny<nested>::lookup_index("abcdefghijklmno"));
+  CHECK(3 == prefix::tiny<nested>::lookup_index("abcdefghijklmnop"));
+  CHECK(3 == prefix::tiny<nested>::lookup_index("abcdefghijklmnopq"));
+  CHECK(4 == prefix::tiny<nested>::lookup_index("b\x80"));
+  CHECK(5 == prefix::tiny<nested>::lookup_index("\xff\xff"));
+}
+
+TEST_CASE("tiny with explicit length")
+{
+  const char buffer[] = "abcdefghijklmnopqrstuvwxyz";
+  CHECK(0 == prefix::tiny<nested>::lookup_index(buffer, 0));
+  CHECK(1 == prefix::tiny<nested>::lookup_index(buffer, 1));
+  CHECK(2 == prefix::tiny<nested>::lookup_index(buffer, 15));
+  CHECK(3 == prefix::tiny<nested>::lookup_index(buffer, 16));
+  CHECK(3 == prefix::tiny<nested>::lookup_index(buffer, 26));
+  CHECK(6 == prefix::tiny<methods>::lookup_index("POSTS", 4));
+  CHECK(9 == prefix::tiny<methods>::lookup_index("POSTS", 3));
+}
+
+TEST_CASE("tiny kernels agree")
+{
+  const prefix::simd_kernel kernels[] = {
+      prefix::simd_kernel::scalar, prefix::simd_kernel::sse2,
+      prefix::simd_kernel::avx2, prefix::simd_kernel::avx512};
+  const char* keys[] = {"GET /index.html", "PUT", "PU",      "POSTAL",
+                        "",                "get", "CONNECTED", "TRACE",
+                        "a",               "abcdefghijklmnopq", "b\x80",
+                        "\xff\xff"};
+  CHECK(prefix::simd_supported(prefix::simd_kernel::scalar));
+  CHECK(prefix::simd_supported(prefix::simd_select()));
+  for (prefix::simd_kernel k : kernels)
+    {
+      if (!prefix::simd_supported(k))
+        {
+          continue;
+        }
+      for (const char* key : keys)
+        {
+          const std::size_t length = std::strlen(key) + 1;
+          CHECK(methods::lookup_index_critbit(key, length) ==
+                prefix::tiny<methods>::lookup_index(k, key, length));
+          CHECK(nested::lookup_index_critbit(key, length) ==
+                prefix::tiny<nested>::lookup_index(k, key, length));
+        }
+    }
+}
+
+TEST_CASE("tiny kernel override")
+{
+  setenv("PREFIX_SIMD", "scalar", 1);
+  CHECK(prefix::simd_kernel::scalar == prefix::simd_select());
+  setenv("PREFIX_SIMD", "no such kernel", 1);
+  CHECK(prefix::simd_supported(prefix::simd_select()));
+  unsetenv("PREFIX_SIMD");
+}
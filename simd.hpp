@@ -0,0 +1,354 @@
+/*
+ * This file is part of PrefixTree
+ *
+ * The MIT License (MIT)
+ * 
+ * Copyright (c) 2016 Jon Chesterfield
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifndef SIMD_HPP
+#define SIMD_HPP
+
+#include "prefix.hpp"
+
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <type_traits>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define PREFIX_SIMD_X86 1
+#include <immintrin.h>
+#endif
+
+namespace prefix
+{
+// Kernels comparing the key against every row, slowest first
+enum class simd_kernel
+{
+  scalar,
+  sse2,
+  avx2,
+  avx512
+};
+
+inline const char* simd_kernel_name(simd_kernel k)
+{
+  return (k == simd_kernel::avx512)
+             ? "avx512"
+             : (k == simd_kernel::avx2)
+                   ? "avx2"
+                   : (k == simd_kernel::sse2) ? "sse2" : "scalar";
+}
+
+// Whether the running CPU can execute kernel k
+inline bool simd_supported(simd_kernel k)
+{
+#ifdef PREFIX_SIMD_X86
+  __builtin_cpu_init();
+  switch (k)
+    {
+      case simd_kernel::avx512:
+        return __builtin_cpu_supports("avx512bw");
+      case simd_kernel::avx2:
+        return __builtin_cpu_supports("avx2");
+      case simd_kernel::sse2:
+        return __builtin_cpu_supports("sse2");
+      default:
+        return true;
+    }
+#else
+  return k == simd_kernel::scalar;
+#endif
+}
+
+// The fastest kernel the running CPU supports. The environment variable
+// PREFIX_SIMD may name another (scalar, sse2, avx2 or avx512) to compare
+// kernels on one machine, it is ignored if the CPU lacks that kernel
+inline simd_kernel simd_select()
+{
+  const simd_kernel all[] = {simd_kernel::avx512, simd_kernel::avx2,
+                             simd_kernel::sse2, simd_kernel::scalar};
+  const char* forced = std::getenv("PREFIX_SIMD");
+  for (simd_kernel k : all)
+    {
+      if (forced && std::strcmp(forced, simd_kernel_name(k)) == 0 &&
+          simd_supported(k))
+        {
+          return k;
+        }
+    }
+  for (simd_kernel k : all)
+    {
+      if (simd_supported(k))
+        {
+          return k;
+        }
+    }
+  return simd_kernel::scalar;
+}
+
+// Branch free lookup for tables of up to 16 rows of up to 16 characters
+// The first 16 characters of the key are loaded once and compared against
+// every row at the same time. Matches as crtp::lookup_index_critbit
+//
+// The kernel is chosen for the running CPU on the first lookup into each
+// table, see simd_select
+template <typename T>
+class tiny
+{
+ public:
+  static std::size_t lookup_index(const char* key)
+  {
+    return lookup_index(key, std::strlen(key) + 1);
+  }
+
+  static std::size_t lookup_index(const char* key, std::size_t length)
+  {
+    return lookup_index_with(selected(), key, length);
+  }
+
+  // As lookup_index using kernel k, which the CPU must support
+  static std::size_t lookup_index(simd_kernel k, const char* key,
+                                  std::size_t length)
+  {
+    return lookup_index_with(matcher(k), key, length);
+  }
+
+ private:
+  typedef unsigned (*match_fn)(const char*, std::size_t);
+
+  static std::size_t lookup_index_with(match_fn matches, const char* key,
+                                       std::size_t length)
+  {
+    static_assert(T::size() > 0 && T::size() <= 16, "Too many rows for tiny");
+    static_assert(T::template max_key_size<0, T::size()>() <= 16,
+                  "Rows too long for tiny");
+    static_assert(T::template ordered<0, T::size()>(),
+                  "Table is not ordered - cannot search");
+
+    // Rows matching the key are prefixes of one another, so the last row
+    // that matches is the longest
+    const unsigned hits = matches(key, length);
+    return T::instrumentation::template record<T>(
+        hits ? 31 - __builtin_clz(hits) : T::fail(), key, length);
+  }
+
+  static match_fn selected()
+  {
+    static const match_fn chosen = matcher(simd_select());
+    return chosen;
+  }
+
+  static match_fn matcher(simd_kernel k)
+  {
+    switch (k)
+      {
+#ifdef PREFIX_SIMD_X86
+        case simd_kernel::avx512:
+          return matches_avx512;
+        case simd_kernel::avx2:
+          return matches_avx2;
+        case simd_kernel::sse2:
+          return matches_sse2;
+#endif
+        default:
+          return matches_scalar;
+      }
+  }
+
+  // Character J of row R, padded with zero, also past the last row
+  template <std::size_t R, std::size_t J>
+  static constexpr char ch()
+  {
+    return (R < T::size() && J < T::get(R).size()) ? T::get(R)[J] : '\0';
+  }
+
+  // Bit J set if row R has a character at J
+  template <std::size_t R>
+  static constexpr unsigned row_mask()
+  {
+    return (1u << T::template get<R>().size()) - 1;
+  }
+
+  // Bit J set if the key has a character at J
+  static unsigned key_mask(std::size_t length)
+  {
+    return (length < 16) ? (1u << length) - 1 : 0xffffu;
+  }
+
+  // Rows R to R + W - 1 that match, given sixteen bits of equal characters
+  // per row from the low bits of eq
+  template <std::size_t R, std::size_t W>
+  static typename std::enable_if<(W == 0 || R >= T::size()), unsigned>::type
+  hits(unsigned long long, unsigned)
+  {
+    return 0;
+  }
+
+  template <std::size_t R, std::size_t W>
+  static typename std::enable_if<(W != 0 && R < T::size()), unsigned>::type
+  hits(unsigned long long eq, unsigned valid)
+  {
+    return (unsigned((unsigned(eq) & valid & row_mask<R>()) == row_mask<R>())
+            << R) |
+           hits<R + 1, W - 1>(eq >> 16, valid);
+  }
+
+  template <std::size_t R>
+  static typename std::enable_if<(R >= T::size()), unsigned>::type
+  match_rows(const char*, unsigned)
+  {
+    return 0;
+  }
+
+  template <std::size_t R>
+  static typename std::enable_if<(R < T::size()), unsigned>::type
+  match_rows(const char* k, unsigned valid)
+  {
+    unsigned eq = 0;
+    for (std::size_t j = 0; j < 16; j++)
+      {
+        eq |= unsigned(k[j] == (j < T::get(R).size() ? T::get(R)[j] : '\0'))
+              << j;
+      }
+    return hits<R, 1>(eq, valid) | match_rows<R + 1>(k, valid);
+  }
+
+  static unsigned matches_scalar(const char* key, std::size_t length)
+  {
+    char buffer[16] = {0};
+    std::memcpy(buffer, key, length < 16 ? length : 16);
+    return match_rows<0>(buffer, key_mask(length));
+  }
+
+#ifdef PREFIX_SIMD_X86
+  // The first 16 characters of the key, zero padded
+  static __m128i load(const char* key, std::size_t length)
+  {
+    if (length < 16)
+      {
+        char buffer[16] = {0};
+        std::memcpy(buffer, key, length);
+        return _mm_loadu_si128(reinterpret_cast<const __m128i*>(buffer));
+      }
+    return _mm_loadu_si128(reinterpret_cast<const __m128i*>(key));
+  }
+
+  template <std::size_t R>
+  static __m128i row()
+  {
+#define TINY_CHAR(J) std::integral_constant<char, ch<R, J>()>::value
+    return _mm_setr_epi8(TINY_CHAR(0), TINY_CHAR(1), TINY_CHAR(2),
+                         TINY_CHAR(3), TINY_CHAR(4), TINY_CHAR(5),
+                         TINY_CHAR(6), TINY_CHAR(7), TINY_CHAR(8),
+                         TINY_CHAR(9), TINY_CHAR(10), TINY_CHAR(11),
+                         TINY_CHAR(12), TINY_CHAR(13), TINY_CHAR(14),
+                         TINY_CHAR(15));
+#undef TINY_CHAR
+  }
+
+  // One row per compare
+  template <std::size_t R>
+  static typename std::enable_if<(R >= T::size()), unsigned>::type
+  match_rows(__m128i, unsigned)
+  {
+    return 0;
+  }
+
+  template <std::size_t R>
+  static typename std::enable_if<(R < T::size()), unsigned>::type
+  match_rows(__m128i k, unsigned valid)
+  {
+    return hits<R, 1>(static_cast<unsigned>(
+                          _mm_movemask_epi8(_mm_cmpeq_epi8(k, row<R>()))),
+                      valid) |
+           match_rows<R + 1>(k, valid);
+  }
+
+  static unsigned matches_sse2(const char* key, std::size_t length)
+  {
+    return match_rows<0>(load(key, length), key_mask(length));
+  }
+
+  // Two rows per compare
+  template <std::size_t R>
+  __attribute__((target("avx2"))) static
+      typename std::enable_if<(R >= T::size()), unsigned>::type
+      match_rows(__m256i, unsigned)
+  {
+    return 0;
+  }
+
+  template <std::size_t R>
+  __attribute__((target("avx2"))) static
+      typename std::enable_if<(R < T::size()), unsigned>::type
+      match_rows(__m256i k, unsigned valid)
+  {
+    const __m256i rows = _mm256_inserti128_si256(
+        _mm256_castsi128_si256(row<R>()), row<R + 1>(), 1);
+    return hits<R, 2>(static_cast<unsigned>(
+                          _mm256_movemask_epi8(_mm256_cmpeq_epi8(k, rows))),
+                      valid) |
+           match_rows<R + 2>(k, valid);
+  }
+
+  __attribute__((target("avx2"))) static unsigned matches_avx2(
+      const char* key, std::size_t length)
+  {
+    return match_rows<0>(_mm256_broadcastsi128_si256(load(key, length)),
+                         key_mask(length));
+  }
+
+  // Four rows per compare
+  template <std::size_t R>
+  __attribute__((target("avx512bw"))) static
+      typename std::enable_if<(R >= T::size()), unsigned>::type
+      match_rows(__m512i, unsigned)
+  {
+    return 0;
+  }
+
+  template <std::size_t R>
+  __attribute__((target("avx512bw"))) static
+      typename std::enable_if<(R < T::size()), unsigned>::type
+      match_rows(__m512i k, unsigned valid)
+  {
+    const __m512i rows = _mm512_inserti64x4(
+        _mm512_castsi256_si512(_mm256_inserti128_si256(
+            _mm256_castsi128_si256(row<R>()), row<R + 1>(), 1)),
+        _mm256_inserti128_si256(_mm256_castsi128_si256(row<R + 2>()),
+                                row<R + 3>(), 1),
+        1);
+    return hits<R, 4>(_mm512_cmpeq_epi8_mask(k, rows), valid) |
+           match_rows<R + 4>(k, valid);
+  }
+
+  __attribute__((target("avx512bw"))) static unsigned matches_avx512(
+      const char* key, std::size_t length)
+  {
+    return match_rows<0>(_mm512_broadcast_i32x4(load(key, length)),
+                         key_mask(length));
+  }
+#endif
+};
+}
+
+#endif  // SIMD_HPP
@@ -0,0 +1,104 @@
+/*
+ * This file is part of PrefixTree
+ *
+ * The MIT License (MIT)
+ * 
+ * Copyright (c) 2016 Jon Chesterfield
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "tokenize.hpp"
+#include "catch.hpp"
+
+#include <string>
+#include <vector>
+
+namespace
+{
+struct operators : prefix::crtp<operators>
+{
+  static constexpr element table[] = {
+      "!", "!=", "(", ")", "+", "++", "+=", "=", "==", "if", "int", "while",
+  };
+};
+}
+constexpr decltype(operators::table) operators::table;
+
+TEST_CASE("delimiters skip")
+{
+  const prefix::delimiters space = prefix::delimiters::whitespace();
+  const std::string blank(40, ' ');
+  CHECK(0 == space.skip("x", 1));
+  CHECK(3 == space.skip(" \t\nx", 4));
+  CHECK(40 == space.skip(blank.c_str(), blank.size()));
+  CHECK(35 == space.skip((blank.substr(0, 35) + "x" + blank).c_str(), 76));
+  CHECK(17 == space.skip((blank.substr(0, 17) + "\x80").c_str(), 18));
+
+  // More characters than one vector compare handles
+  const prefix::delimiters many("abcdefghijklmnopqrstuvwxyz");
+  CHECK(26 == many.skip("zyxwvutsrqponmlkjihgfedcba!", 27));
+  CHECK(many.contains('q'));
+  CHECK(!many.contains('!'));
+}
+
+TEST_CASE("tokenizer")
+{
+  const char text[] = "while (i != 10)\n  i += 1; if(int)";
+  prefix::tokenizer<operators> lex(text, sizeof(text) - 1,
+                                   prefix::delimiters::whitespace());
+  prefix::token out[4];
+  std::vector<prefix::token> all;
+  while (std::size_t n = lex.next(out, 4))
+    {
+      all.insert(all.end(), out, out + n);
+    }
+  CHECK(lex.done());
+  CHECK(lex.offset() == sizeof(text) - 1);
+
+  const char* expect[] = {"while", "(", "i", "!=", "10", ")", "i", "+=",
+                          "1;", "if", "(", "int", ")"};
+  REQUIRE(all.size() == sizeof(expect) / sizeof(expect[0]));
+  for (std::size_t i = 0; i < all.size(); i++)
+    {
+      CHECK(std::string(text + all[i].offset, all[i].length) == expect[i]);
+      if (all[i].index != operators::fail())
+        {
+          CHECK(operators::get(all[i].index).size() == all[i].length);
+        }
+    }
+  CHECK(operators::fail() == all[2].index);
+  CHECK(1 == all[3].index);
+  CHECK(6 == all[7].index);
+  CHECK(operators::fail() == all[8].index);
+}
+
+TEST_CASE("tokenizer at the end of the buffer")
+{
+  // Only the first two characters belong to the buffer
+  prefix::tokenizer<operators> lex("+++", 2, prefix::delimiters(" "));
+  prefix::token out[4];
+  REQUIRE(1 == lex.next(out, 4));
+  CHECK(5 == out[0].index);
+  CHECK(2 == out[0].length);
+  CHECK(0 == lex.next(out, 4));
+
+  prefix::tokenizer<operators> empty("", 0, prefix::delimiters(" "));
+  CHECK(empty.done());
+  CHECK(0 == empty.next(out, 4));
+}
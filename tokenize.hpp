@@ -0,0 +1,196 @@
+/*
+ * This file is part of PrefixTree
+ *
+ * The MIT License (MIT)
+ * 
+ * Copyright (c) 2016 Jon Chesterfield
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifndef TOKENIZE_HPP
+#define TOKENIZE_HPP
+
+#include "prefix.hpp"
+
+#include <cstddef>
+#include <cstring>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+namespace prefix
+{
+// Characters skipped between tokens. Up to 16 distinct characters are
+// tested 16 bytes of input at a time, a longer class falls back to a
+// table lookup per byte
+class delimiters
+{
+ public:
+  explicit delimiters(const char* chars) : count(0)
+  {
+    std::memset(member, 0, sizeof(member));
+    for (const char* c = chars; *c; c++)
+      {
+        const unsigned char u = static_cast<unsigned char>(*c);
+        if (!member[u])
+          {
+            member[u] = true;
+            if (count < 16)
+              {
+                list[count] = *c;
+              }
+            count++;
+          }
+      }
+  }
+
+  static delimiters whitespace() { return delimiters(" \t\n\v\f\r"); }
+
+  bool contains(char c) const
+  {
+    return member[static_cast<unsigned char>(c)];
+  }
+
+  // Number of leading characters of data, up to length, in the class
+  std::size_t skip(const char* data, std::size_t length) const
+  {
+    std::size_t i = 0;
+#ifdef __SSE2__
+    if (count <= 16)
+      {
+        for (; i + 16 <= length; i += 16)
+          {
+            const __m128i d =
+                _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+            __m128i hit = _mm_setzero_si128();
+            for (std::size_t j = 0; j < count; j++)
+              {
+                hit = _mm_or_si128(hit,
+                                   _mm_cmpeq_epi8(d, _mm_set1_epi8(list[j])));
+              }
+            const unsigned miss =
+                ~static_cast<unsigned>(_mm_movemask_epi8(hit)) & 0xffffu;
+            if (miss)
+              {
+                return i + __builtin_ctz(miss);
+              }
+          }
+      }
+#endif
+    while (i < length && contains(data[i]))
+      {
+        i++;
+      }
+    return i;
+  }
+
+ private:
+  bool member[256];
+  char list[16];
+  std::size_t count;
+};
+
+// Row index matched at offset into the buffer, length characters long.
+// Characters no row matches are reported together, up to the next
+// delimiter or match, with index fail()
+struct token
+{
+  std::size_t index;
+  std::size_t offset;
+  std::size_t length;
+};
+
+// Splits a buffer into the longest rows of T matching at each position,
+// skipping delimiters between them. Tokens are written to storage the
+// caller provides, so lexing allocates nothing:
+//   prefix::token out[256];
+//   prefix::tokenizer<T> lex(data, length, prefix::delimiters::whitespace());
+//   while (std::size_t n = lex.next(out, 256)) { ... }
+template <typename T>
+class tokenizer
+{
+ public:
+  tokenizer(const char* data, std::size_t length, const delimiters& skipped)
+      : data(data), length(length), position(0), skipped(skipped)
+  {
+  }
+
+  // Writes up to capacity tokens to out, returning the number written.
+  // Zero once the buffer is used up
+  std::size_t next(token* out, std::size_t capacity)
+  {
+    std::size_t n = 0;
+    while (n < capacity)
+      {
+        position += skipped.skip(data + position, length - position);
+        if (position == length)
+          {
+            break;
+          }
+        out[n++] = match();
+        position += out[n - 1].length;
+      }
+    return n;
+  }
+
+  bool done() const
+  {
+    return position + skipped.skip(data + position, length - position) ==
+           length;
+  }
+
+  // Offset of the next character to be tokenized
+  std::size_t offset() const { return position; }
+
+ private:
+  token match() const
+  {
+    const char* at = data + position;
+    const std::size_t left = length - position;
+    const std::size_t index = matched(at, left);
+    if (index != T::fail())
+      {
+        return token{index, position, T::get(index).size()};
+      }
+    std::size_t end = 1;
+    while (end < left && !skipped.contains(at[end]) &&
+           matched(at + end, left - end) == T::fail())
+      {
+        end++;
+      }
+    return token{T::fail(), position, end};
+  }
+
+  // Longest row prefixing key. An empty row would match without moving on
+  static std::size_t matched(const char* key, std::size_t length)
+  {
+    const std::size_t index = T::lookup_index_critbit(key, length);
+    return (index != T::fail() && T::get(index).size() != 0) ? index
+                                                             : T::fail();
+  }
+
+  const char* data;
+  std::size_t length;
+  std::size_t position;
+  delimiters skipped;
+};
+}
+
+#endif  // TOKENIZE_HPP